@@ -0,0 +1,93 @@
+#ifndef VLFW_COMMAND_QUEUE_HPP
+#define VLFW_COMMAND_QUEUE_HPP
+
+#include "ValkyrieEngine/ValkyrieEngine.hpp"
+
+#include <atomic>
+#include <functional>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		/*!
+		 * \brief Lock-free multiple producer, single consumer queue of
+		 * commands
+		 *
+		 * Any number of threads may push commands without blocking, a single
+		 * thread executes them in the order they were pushed.
+		 */
+		class CommandQueue
+		{
+			struct Node
+			{
+				std::atomic<Node*> next;
+				std::function<void()> command;
+			};
+
+			// Producers append here
+			std::atomic<Node*> head;
+
+			// Only touched by the consumer
+			Node* tail;
+			Node stub;
+
+			void PushNode(Node* n);
+			Node* PopNode();
+
+			public:
+			CommandQueue();
+
+			CommandQueue(const CommandQueue&) = delete;
+			CommandQueue(CommandQueue&&) = delete;
+			CommandQueue& operator=(const CommandQueue&) = delete;
+			CommandQueue& operator=(CommandQueue&&) = delete;
+
+			/*!
+			 * \brief Destroys the queue and any commands that were not
+			 * executed
+			 */
+			~CommandQueue();
+
+			/*!
+			 * \brief Adds a command to the end of the queue
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void Push(std::function<void()> command);
+
+			/*!
+			 * \brief Executes queued commands in the order they were pushed
+			 *
+			 * Only commands pushed before the call are executed, commands
+			 * pushed while executing are left for the next call. Commands
+			 * that a producer has not finished pushing may also be left for
+			 * the next call.
+			 *
+			 * \returns The number of commands executed
+			 *
+			 * \ts
+			 * This function may be called from any thread, but only one
+			 * thread may consume from a queue.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			Size Execute();
+
+			/*!
+			 * \brief Returns true if there are no commands waiting to be
+			 * executed
+			 *
+			 * \ts
+			 * This function may only be called from the consuming thread.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			bool IsEmpty() const;
+		};
+	}
+}
+
+#endif
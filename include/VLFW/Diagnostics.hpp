@@ -0,0 +1,115 @@
+#ifndef VLFW_DIAGNOSTICS_HPP
+#define VLFW_DIAGNOSTICS_HPP
+
+#include "ValkyrieEngine/ValkyrieEngine.hpp"
+
+#include "FrameArena.hpp"
+
+#include <cstdint>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		//! Where a diagnostic message came from
+		enum class DiagnosticSource
+		{
+			//! A GLFW error
+			GLFW =           0x00000000,
+
+			//! OpenGL debug output
+			OpenGL =         0x00000001,
+
+			//! A Vulkan validation layer or driver, through VK_EXT_debug_utils
+			Vulkan =         0x00000002
+		};
+
+		//! How serious a diagnostic message is
+		enum class DiagnosticSeverity
+		{
+			//! Informational and verbose messages
+			Info =           0x00000000,
+
+			//! Suspicious or slow usage
+			Warning =        0x00000001,
+
+			//! Errors and undefined behaviour
+			Error =          0x00000002
+		};
+
+		//! Arguments for VLFW's diagnostics pipeline
+		struct DiagnosticsArgs
+		{
+			/*!
+			 * \brief Messages less severe than this are discarded when they
+			 * are recieved
+			 *
+			 * Vulkan debug messengers are only subscribed to severities that
+			 * are kept, so validation layers skip the callback for the rest.
+			 */
+			DiagnosticSeverity minSeverity = DiagnosticSeverity::Warning;
+
+			/*!
+			 * \brief Maximum number of messages held between frames
+			 *
+			 * Rounded up to a power of two. Messages recieved while the
+			 * buffer is full are dropped and counted.
+			 */
+			Size capacity = 1024;
+
+			/*!
+			 * \brief Minimum time, in seconds, between two DiagnosticEvent%s
+			 * for the same message
+			 *
+			 * Repeats within the interval are counted and reported with the
+			 * next event for that message.
+			 */
+			Double repeatInterval = 1.0;
+
+			//! Install an OpenGL debug message callback for windows created with WindowHints::openglDebugContext
+			bool openglDebugOutput = true;
+
+			//! Create a VK_EXT_debug_utils messenger for Vulkan instances created with validation layers
+			bool vulkanDebugMessenger = true;
+		};
+
+		/*!
+		 * \brief Sent at the end of a frame for diagnostic messages
+		 * recieved during it
+		 *
+		 * Messages with the same source and ID are reported at most once per
+		 * DiagnosticsArgs::repeatInterval. OpenGL messages are also told
+		 * apart by their GL source and type, Vulkan messages by their type.
+		 * GLFW errors, and messages without an ID, are told apart by their
+		 * description as well.
+		 *
+		 * \sa VLFWMainArgs::diagnostics
+		 */
+		struct DiagnosticEvent
+		{
+			DiagnosticSource source;
+			DiagnosticSeverity severity;
+
+			/*!
+			 * \brief Identifies the message within its source
+			 *
+			 * The GLFW error code, the OpenGL message ID, or the Vulkan
+			 * message ID number.
+			 */
+			std::int64_t id;
+
+			/*!
+			 * \brief The message, truncated if very long
+			 *
+			 * Allocated from VLFWMain's frame arena, valid until the end of
+			 * the frame.
+			 */
+			ArenaString message;
+
+			//! Number of times the message was recieved since it was last reported, at least 1
+			Size count;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef VLFW_FRAME_ARENA_HPP
+#define VLFW_FRAME_ARENA_HPP
+
+#include "ValkyrieEngine/ValkyrieEngine.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		/*!
+		 * \brief A null terminated string that does not own its memory
+		 *
+		 * Strings in VLFW events are allocated from a FrameArena and remain
+		 * valid until the end of the frame they were sent in. Copy them with
+		 * ToString() to keep them for longer.
+		 */
+		struct ArenaString
+		{
+			//! Null terminated, UTF-8 encoded characters
+			const char* data;
+
+			//! Number of bytes, not including the null terminator
+			Size length;
+
+			//! Copies the string into a <tt>std::string</tt>
+			inline std::string ToString() const { return std::string(data, length); }
+
+			//! Gets the null terminated characters
+			inline const char* c_str() const { return data; }
+
+			//! Copies the string into a <tt>std::string</tt>
+			inline operator std::string() const { return ToString(); }
+		};
+
+		//! Writes the string's characters to a stream
+		inline std::ostream& operator<<(std::ostream& os, const ArenaString& str)
+		{
+			return os.write(str.data, static_cast<std::streamsize>(str.length));
+		}
+
+		/*!
+		 * \brief Bump allocator whose allocations are all freed at once
+		 *
+		 * Allocating only advances an offset into a block of memory, and
+		 * Reset() makes all of it available again without calling the
+		 * general heap. When a block runs out, a larger one is added, and
+		 * the next Reset() replaces every block with a single block large
+		 * enough for the whole frame, so steady state use does not allocate.
+		 *
+		 * VLFWMain owns an arena that payloads of window events are
+		 * allocated from, it is reset at the end of each frame. Payloads of
+		 * events deferred to a later frame are handed to another arena
+		 * until they have been sent.
+		 *
+		 * Destructors of objects allocated from an arena are never called.
+		 */
+		class FrameArena
+		{
+			struct Block
+			{
+				std::unique_ptr<char[]> data;
+				Size size;
+			};
+
+			std::vector<Block> blocks;
+			Size offset;
+			Size used;
+
+			public:
+			/*!
+			 * \brief Constructs an arena with a single block
+			 *
+			 * \param initialSize Size of the first block, in bytes
+			 */
+			FrameArena(Size initialSize = 16 * 1024);
+
+			FrameArena(const FrameArena&) = delete;
+			FrameArena(FrameArena&&) = delete;
+			FrameArena& operator=(const FrameArena&) = delete;
+			FrameArena& operator=(FrameArena&&) = delete;
+			~FrameArena() = default;
+
+			/*!
+			 * \brief Allocates uninitialized memory
+			 *
+			 * \param alignment Must be a power of two
+			 *
+			 * \ts
+			 * This function must only be called from the thread that owns
+			 * the arena.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void* Allocate(Size size, Size alignment = alignof(std::max_align_t));
+
+			/*!
+			 * \brief Allocates uninitialized memory for an array of T
+			 *
+			 * T must be trivially destructible.
+			 */
+			template<typename T>
+			inline T* Allocate(Size count)
+			{
+				return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+			}
+
+			/*!
+			 * \brief Copies a string into the arena, adding a null terminator
+			 *
+			 * \ts
+			 * This function must only be called from the thread that owns
+			 * the arena.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			ArenaString Copy(const char* str, Size length);
+
+			//! Copies a null terminated string into the arena
+			ArenaString Copy(const char* str);
+
+			/*!
+			 * \brief Exchanges the blocks and allocations of two arenas
+			 *
+			 * Memory allocated from either arena stays valid and now belongs
+			 * to the other one.
+			 */
+			void Swap(FrameArena& other);
+
+			/*!
+			 * \brief Frees everything allocated from the arena
+			 *
+			 * Anything previously allocated must no longer be used.
+			 *
+			 * \ts
+			 * This function must only be called from the thread that owns
+			 * the arena.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void Reset();
+
+			//! Gets the number of bytes allocated since the last reset
+			inline Size GetUsed() const { return used; }
+
+			//! Gets the total size of the arena's blocks, in bytes
+			Size GetCapacity() const;
+		};
+	}
+}
+
+#endif
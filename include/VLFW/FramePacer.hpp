@@ -0,0 +1,206 @@
+#ifndef VLFW_FRAME_PACER_HPP
+#define VLFW_FRAME_PACER_HPP
+
+#include "ValkyrieEngine/ValkyrieEngine.hpp"
+
+#include "Monitor.hpp"
+#include "Window.hpp"
+
+#include <chrono>
+#include <vector>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		//! Arguments for FramePacer
+		struct FramePacerArgs
+		{
+			/*!
+			 * \brief Window whose monitor determines the refresh rate
+			 *
+			 * If <tt>nullptr</tt>, the refresh rate of the primary monitor is
+			 * used. The pacer VLFWMain constructs ignores this and follows
+			 * the first window it swaps, skipping windows that are minimized
+			 * or throttled, since no window can exist before VLFWMain.
+			 *
+			 * \sa FramePacer::SetWindow()
+			 */
+			Window* window = nullptr;
+
+			//! Maximum frame rate in Hz, or 0 for no cap other than the refresh rate
+			Double frameRateCap = 0.0;
+
+			//! Extra time, in seconds, allowed on top of the estimated frame cost
+			Double safetyMargin = 0.002;
+
+			/*!
+			 * \brief Time, in seconds, before a frame should start at which
+			 * to stop sleeping and start spinning
+			 *
+			 * Sleeping is cheap but imprecise, spinning is precise but keeps
+			 * a core busy. Raise this on platforms with a coarse scheduler.
+			 */
+			Double spinThreshold = 0.002;
+
+			/*!
+			 * \brief Number of recent frames to consider when estimating the
+			 * cost of the next frame
+			 *
+			 * The most expensive of these frames is used as the estimate.
+			 */
+			Size costSamples = 30;
+		};
+
+		/*!
+		 * \brief Delays the start of each frame so it finishes just before
+		 * the next vertical blank
+		 *
+		 * Starting a frame as late as possible means input is sampled as
+		 * late as possible, and the CPU sleeps instead of blocking in a swap.
+		 * The pacer estimates the cost of a frame from the time between the
+		 * start of recent frames and their buffer swaps, and aligns frames to
+		 * the refresh interval of the target window's monitor, or to
+		 * FramePacerArgs::frameRateCap if that is lower.
+		 *
+		 * VLFWMain constructs and drives a FramePacer when
+		 * VLFWMainArgs::framePacing is set, it may also be driven manually:
+		 *
+		 * \code
+		 * pacer.WaitForFrameStart();
+		 * // Poll events, update, render
+		 * pacer.MarkWorkDone();
+		 * // Swap buffers
+		 * pacer.MarkPresented();
+		 * \endcode
+		 */
+		class FramePacer final :
+			public EventListener<Window::MoveEvent>,
+			public EventListener<Monitor::ConnectEvent>,
+			public EventListener<Monitor::DisconnectEvent>
+		{
+			public:
+			typedef std::chrono::steady_clock Clock;
+
+			private:
+			Window* window;
+			Double frameRateCap;
+			Double safetyMargin;
+			Double spinThreshold;
+
+			Double period;
+			bool periodDirty;
+
+			std::vector<Double> costs;
+			Size nextCost;
+
+			Clock::time_point frameStart;
+			Clock::time_point lastPresent;
+			bool presented;
+
+			void UpdatePeriod();
+
+			public:
+			inline FramePacer() : FramePacer(FramePacerArgs{}) {}
+			FramePacer(const FramePacerArgs& args);
+
+			FramePacer(const FramePacer&) = delete;
+			FramePacer(FramePacer&&) = delete;
+			FramePacer& operator=(const FramePacer&) = delete;
+			FramePacer& operator=(FramePacer&&) = delete;
+			~FramePacer() = default;
+
+			void OnEvent(const Window::MoveEvent& ev) override;
+			void OnEvent(const Monitor::ConnectEvent& ev) override;
+			void OnEvent(const Monitor::DisconnectEvent& ev) override;
+
+			/*!
+			 * \brief Blocks until the next frame should start
+			 *
+			 * Sleeps for most of the wait and spins for the remainder.
+			 * Returns immediately if the previous frame ran late.
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void WaitForFrameStart();
+
+			/*!
+			 * \brief Records that the frame's work is done and its buffers
+			 * are about to be swapped
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void MarkWorkDone();
+
+			/*!
+			 * \brief Records that the frame's buffers have been swapped
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void MarkPresented();
+
+			/*!
+			 * \brief Gets the time between frames the pacer is aiming for,
+			 * in seconds
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			Double GetFramePeriod();
+
+			/*!
+			 * \brief Gets the estimated cost of the next frame, in seconds
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			Double GetEstimatedFrameCost() const;
+
+			/*!
+			 * \brief Changes the window whose monitor determines the
+			 * refresh rate
+			 *
+			 * The refresh rate is queried again when the window moves. Pass
+			 * <tt>nullptr</tt> to use the primary monitor, a window must be
+			 * unset before it is destroyed. VLFWMain sets the window of its
+			 * own pacer at the start of each frame.
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void SetWindow(Window* window);
+
+			//! Gets the window whose monitor determines the refresh rate, or <tt>nullptr</tt>
+			inline Window* GetWindow() const { return window; }
+
+			/*!
+			 * \brief Changes the frame rate cap
+			 *
+			 * \sa FramePacerArgs::frameRateCap
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void SetFrameRateCap(Double cap);
+		};
+	}
+}
+
+#endif
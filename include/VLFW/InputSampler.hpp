@@ -0,0 +1,187 @@
+#ifndef VLFW_INPUT_SAMPLER_HPP
+#define VLFW_INPUT_SAMPLER_HPP
+
+#include "ValkyrieEngine/ValkyrieEngine.hpp"
+
+#include "Window.hpp"
+#include "InputSnapshot.hpp"
+
+#include <chrono>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		//! Arguments for InputSampler
+		struct InputSamplerArgs
+		{
+			//! Duration of a single simulation tick, in seconds
+			Double tickDuration = 1.0 / 240.0;
+
+			//! Number of past ticks to retain snapshots for
+			Size historyLength = 256;
+		};
+
+		/*!
+		 * \brief Buckets input events into fixed-duration simulation ticks
+		 *
+		 * Unlike the Keyboard and Mouse classes, whose pressed and released
+		 * states last for a whole render frame, an InputSampler timestamps
+		 * each input event as it is recieved and assigns it to the
+		 * simulation tick it occurred in. Running several fixed ticks per
+		 * frame, every press and release is then seen by exactly one tick.
+		 *
+		 * Ticks are counted from the construction of the sampler. GLFW does
+		 * not report the time at which the OS generated an event, so events
+		 * are stamped with the time VLFW recieves them, which is the time
+		 * events are processed during a <tt>PreUpdateEvent</tt>.
+		 *
+		 * Any number of samplers may be constructed at once, for example to
+		 * sample physics and AI input at different rates.
+		 */
+		class InputSampler final :
+			public EventListener<Window::KeyDownEvent>,
+			public EventListener<Window::KeyUpEvent>,
+			public EventListener<Window::MouseButtonDownEvent>,
+			public EventListener<Window::MouseButtonUpEvent>,
+			public EventListener<Window::MouseMoveEvent>,
+			public EventListener<Window::ScrollEvent>
+		{
+			public:
+			typedef std::chrono::steady_clock Clock;
+
+			private:
+			InputHistory history;
+			InputSnapshot current;
+			Clock::time_point epoch;
+			Double tickDuration;
+
+			void Advance(std::uint64_t tick);
+			void Sample();
+
+			public:
+			inline InputSampler() : InputSampler(InputSamplerArgs{}) {}
+			InputSampler(const InputSamplerArgs& args);
+
+			InputSampler(const InputSampler&) = delete;
+			InputSampler(InputSampler&&) = delete;
+			InputSampler& operator=(const InputSampler&) = delete;
+			InputSampler& operator=(InputSampler&&) = delete;
+			~InputSampler() = default;
+
+			void OnEvent(const Window::KeyDownEvent& ev) override;
+			void OnEvent(const Window::KeyUpEvent& ev) override;
+			void OnEvent(const Window::MouseButtonDownEvent& ev) override;
+			void OnEvent(const Window::MouseButtonUpEvent& ev) override;
+			void OnEvent(const Window::MouseMoveEvent& ev) override;
+			void OnEvent(const Window::ScrollEvent& ev) override;
+
+			/*!
+			 * \brief Gets the tick that the given point in time falls into
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			std::uint64_t GetTick(Clock::time_point time) const;
+
+			/*!
+			 * \brief Gets the tick that is currently in progress
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			inline std::uint64_t GetCurrentTick() const { return GetTick(Clock::now()); }
+
+			//! Gets the duration of a single tick, in seconds
+			inline Double GetTickDuration() const { return tickDuration; }
+
+			/*!
+			 * \brief Gets the input recorded during the given tick
+			 *
+			 * If the tick is still in progress, the returned snapshot may
+			 * still change as new events are recieved.
+			 *
+			 * \returns <tt>nullptr</tt> if the tick has not started yet or
+			 * is older than InputSamplerArgs::historyLength ticks.
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			const InputSnapshot* GetSnapshot(std::uint64_t tick);
+
+			/*!
+			 * \brief Returns true if the given key was held down at the end
+			 * of the given tick
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			bool IsKeyDown(Key key, std::uint64_t tick);
+
+			/*!
+			 * \brief Returns true if the given key was pressed during the
+			 * given tick
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			bool IsKeyPressed(Key key, std::uint64_t tick);
+
+			/*!
+			 * \brief Returns true if the given key was released during the
+			 * given tick
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			bool IsKeyReleased(Key key, std::uint64_t tick);
+
+			/*!
+			 * \brief Returns true if the given mouse button was held down at
+			 * the end of the given tick
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			bool IsButtonDown(MouseButton button, std::uint64_t tick);
+
+			/*!
+			 * \brief Returns true if the given mouse button was pressed
+			 * during the given tick
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			bool IsButtonPressed(MouseButton button, std::uint64_t tick);
+
+			/*!
+			 * \brief Returns true if the given mouse button was released
+			 * during the given tick
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			bool IsButtonReleased(MouseButton button, std::uint64_t tick);
+		};
+	}
+}
+
+#endif
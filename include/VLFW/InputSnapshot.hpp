@@ -0,0 +1,228 @@
+#ifndef VLFW_INPUT_SNAPSHOT_HPP
+#define VLFW_INPUT_SNAPSHOT_HPP
+
+#include "Input.hpp"
+
+#include "ValkyrieEngineCommon/Types.hpp"
+#include "ValkyrieEngineCommon/Vector.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		/*!
+		 * \brief Fixed-size, bit-packed record of keyboard and mouse state
+		 * for a single tick.
+		 *
+		 * Keys are stored by their platform-independant Key token rather
+		 * than by scancode, so snapshots may safely be exchanged between
+		 * machines. Snapshots can be filled by KeyboardMain::WriteSnapshot()
+		 * and MouseMain::WriteSnapshot(), and compressed against a previous
+		 * snapshot with EncodeDelta().
+		 */
+		struct InputSnapshot
+		{
+			//! Number of 64-bit words needed to store one bit per key token
+			static constexpr Size KeyWordCount = (static_cast<Size>(Key::Last) + 64) / 64;
+
+			//! Number of mouse buttons tracked by a snapshot
+			static constexpr Size MouseButtonCount = 8;
+
+			/*!
+			 * \brief Upper bound on the number of bytes written by EncodeDelta()
+			 *
+			 * Tick (10 byte varint) + field mask (5 byte varint) + every key
+			 * word + button states + mouse position + scroll delta.
+			 */
+			static constexpr Size MaxEncodedSize = 10 + 5 + (KeyWordCount * 3 * 8) + 3 + 8 + 8;
+
+			//! Simulation tick this snapshot was taken on
+			std::uint64_t tick = 0;
+
+			//! Keys that are currently down
+			std::uint64_t keysDown[KeyWordCount] = {};
+
+			//! Keys pressed during this tick
+			std::uint64_t keysPressed[KeyWordCount] = {};
+
+			//! Keys released during this tick
+			std::uint64_t keysReleased[KeyWordCount] = {};
+
+			//! Mouse buttons that are currently down, one bit per button
+			std::uint8_t buttonsDown = 0;
+
+			//! Mouse buttons pressed during this tick
+			std::uint8_t buttonsPressed = 0;
+
+			//! Mouse buttons released during this tick
+			std::uint8_t buttonsReleased = 0;
+
+			//! Position of the mouse in screen units
+			Vector2 mousePos;
+
+			//! Amount scrolled during this tick
+			Vector2 scrollDelta;
+
+			//! Returns true if the given key was down when the snapshot was taken
+			inline bool IsKeyDown(Key key) const { return TestBit(keysDown, key); }
+
+			//! Returns true if the given key was pressed during this tick
+			inline bool IsKeyPressed(Key key) const { return TestBit(keysPressed, key); }
+
+			//! Returns true if the given key was released during this tick
+			inline bool IsKeyReleased(Key key) const { return TestBit(keysReleased, key); }
+
+			//! Returns true if the given button was down when the snapshot was taken
+			inline bool IsButtonDown(MouseButton b) const { return TestBit(buttonsDown, b); }
+
+			//! Returns true if the given button was pressed during this tick
+			inline bool IsButtonPressed(MouseButton b) const { return TestBit(buttonsPressed, b); }
+
+			//! Returns true if the given button was released during this tick
+			inline bool IsButtonReleased(MouseButton b) const { return TestBit(buttonsReleased, b); }
+
+			//! Marks the given key as down and pressed
+			void PressKey(Key key);
+
+			//! Marks the given key as up and released
+			void ReleaseKey(Key key);
+
+			//! Marks the given button as down and pressed
+			void PressButton(MouseButton button);
+
+			//! Marks the given button as up and released
+			void ReleaseButton(MouseButton button);
+
+			/*!
+			 * \brief Clears all pressed and released edges and the scroll
+			 * delta, leaving held keys and buttons untouched.
+			 *
+			 * Used to carry a snapshot over into the next tick.
+			 */
+			void ClearEdges();
+
+			/*!
+			 * \brief Writes the difference between two snapshots into a buffer
+			 *
+			 * Only the fields that changed between <tt>base</tt> and
+			 * <tt>current</tt> are written, so consecutive snapshots with no
+			 * new input encode to two bytes. Encoding against a
+			 * default-constructed snapshot produces a full record.
+			 *
+			 * \param base The snapshot the receiver already has
+			 * \param current The snapshot to encode
+			 * \param out A buffer of at least MaxEncodedSize bytes
+			 *
+			 * \returns The number of bytes written to <tt>out</tt>
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			static Size EncodeDelta(const InputSnapshot& base, const InputSnapshot& current, unsigned char* out);
+
+			/*!
+			 * \brief Reconstructs a snapshot from a base snapshot and the
+			 * output of EncodeDelta()
+			 *
+			 * \returns The number of bytes consumed, or 0 if <tt>data</tt>
+			 * was truncated or malformed, in which case <tt>out</tt> is left
+			 * unspecified.
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			static Size DecodeDelta(const InputSnapshot& base, const unsigned char* data, Size size, InputSnapshot& out);
+
+			bool operator==(const InputSnapshot& other) const;
+			inline bool operator!=(const InputSnapshot& other) const { return !(*this == other); }
+
+			private:
+			inline static bool TestBit(const std::uint64_t* words, Key key)
+			{
+				Int k = static_cast<Int>(key);
+				if (k < 0 || k > static_cast<Int>(Key::Last)) return false;
+				return (words[k >> 6] >> (k & 63)) & 1;
+			}
+
+			inline static bool TestBit(std::uint8_t buttons, MouseButton button)
+			{
+				Int b = static_cast<Int>(button);
+				if (b < 0 || b >= static_cast<Int>(MouseButtonCount)) return false;
+				return (buttons >> b) & 1;
+			}
+		};
+
+		/*!
+		 * \brief Ring buffer holding the snapshots of the last N ticks
+		 *
+		 * Snapshots are slotted by tick number, so looking up the snapshot
+		 * for a given tick is a single index operation. Intended to be used
+		 * for rollback, where the input of past ticks must be replayed.
+		 */
+		class InputHistory
+		{
+			std::vector<InputSnapshot> ring;
+			std::vector<bool> occupied;
+			Size latest;
+
+			public:
+
+			/*!
+			 * \brief Constructs a history that retains <tt>capacity</tt> ticks
+			 */
+			InputHistory(Size capacity);
+
+			InputHistory() = delete;
+			InputHistory(const InputHistory&) = default;
+			InputHistory(InputHistory&&) = default;
+			InputHistory& operator=(const InputHistory&) = default;
+			InputHistory& operator=(InputHistory&&) = default;
+			~InputHistory() = default;
+
+			/*!
+			 * \brief Stores a snapshot, overwriting the snapshot that was
+			 * recorded <tt>capacity</tt> ticks earlier
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void Push(const InputSnapshot& snapshot);
+
+			/*!
+			 * \brief Gets the snapshot recorded for the given tick
+			 *
+			 * \returns <tt>nullptr</tt> if no snapshot was recorded for that
+			 * tick or it has since been overwritten.
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			const InputSnapshot* Find(std::uint64_t tick) const;
+
+			/*!
+			 * \brief Gets the most recently pushed snapshot, or
+			 * <tt>nullptr</tt> if the history is empty
+			 */
+			inline const InputSnapshot* Latest() const
+			{
+				return occupied[latest] ? &ring[latest] : nullptr;
+			}
+
+			//! Gets the number of ticks this history retains
+			inline Size GetCapacity() const { return ring.size(); }
+
+			//! Removes every snapshot from the history
+			void Clear();
+		};
+	}
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include "ValkyrieEngine/ValkyrieEngine.hpp"
 
 #include "Window.hpp"
+#include "InputSnapshot.hpp"
 
 namespace vlk
 {
@@ -140,6 +141,22 @@ namespace vlk
 			void OnEvent(const Window::KeyDownEvent& ev) override;
 			void OnEvent(const Window::KeyUpEvent& ev) override;
 			void OnEvent(const PostUpdateEvent& ev) override;
+
+			/*!
+			 * \brief Writes the current keyboard state into a snapshot
+			 *
+			 * Only the key fields of the snapshot are written, the tick and
+			 * mouse fields are left untouched. Keys without a key token
+			 * (Key::Unknown) are not recorded.
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 *
+			 * \sa MouseMain::WriteSnapshot()
+			 */
+			static void WriteSnapshot(InputSnapshot& snapshot);
 		};
 	}
 }
@@ -0,0 +1,75 @@
+#ifndef VLFW_MAPPED_FILE_HPP
+#define VLFW_MAPPED_FILE_HPP
+
+#include "ValkyrieEngine/ValkyrieEngine.hpp"
+
+#include <string>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		/*!
+		 * \brief A file mapped read-only into memory
+		 *
+		 * The contents of the file are paged in by the operating system as
+		 * they are accessed, nothing is copied up front. The mapping is
+		 * released when the object is destroyed.
+		 */
+		class MappedFile
+		{
+			const void* data;
+			Size size;
+			std::string path;
+
+			public:
+			/*!
+			 * \brief Maps a file into memory
+			 *
+			 * Throws a std::runtime_error if the file can not be opened or
+			 * mapped, or is not a regular file. Empty files are not mapped,
+			 * GetData() returns <tt>nullptr</tt> for them.
+			 *
+			 * \param path UTF-8 encoded path to the file
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			MappedFile(const std::string& path);
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile(MappedFile&&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+			MappedFile& operator=(MappedFile&&) = delete;
+
+			//! Unmaps the file
+			~MappedFile();
+
+			/*!
+			 * \brief Reads the whole file into memory ahead of use
+			 *
+			 * Takes the page faults for every page of the file on the
+			 * calling thread, so reading the contents later does not block
+			 * on disk. Pages may still be evicted again under memory
+			 * pressure.
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void Prefetch() const;
+
+			//! Gets a pointer to the start of the file's contents
+			inline const void* GetData() const { return data; }
+
+			//! Gets the size of the file, in bytes
+			inline Size GetSize() const { return size; }
+
+			//! Gets the path the file was mapped from
+			inline const std::string& GetPath() const { return path; }
+		};
+	}
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include "ValkyrieEngine/ValkyrieEngine.hpp"
 
 #include "Window.hpp"
+#include "InputSnapshot.hpp"
 
 namespace vlk
 {
@@ -139,6 +140,21 @@ namespace vlk
 			void OnEvent(const Window::MouseMoveEvent&) override;
 			void OnEvent(const Window::ScrollEvent&) override;
 			void OnEvent(const PostUpdateEvent&) override;
+
+			/*!
+			 * \brief Writes the current mouse state into a snapshot
+			 *
+			 * Only the button, position and scroll fields of the snapshot are
+			 * written, the tick and key fields are left untouched.
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 *
+			 * \sa KeyboardMain::WriteSnapshot()
+			 */
+			static void WriteSnapshot(InputSnapshot& snapshot);
 		};
 	}
 }
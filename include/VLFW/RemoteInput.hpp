@@ -0,0 +1,205 @@
+#ifndef VLFW_REMOTE_INPUT_HPP
+#define VLFW_REMOTE_INPUT_HPP
+
+#include "ValkyrieEngine/ValkyrieEngine.hpp"
+
+#include "Window.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		/*!
+		 * \brief Socket type RemoteInput listens on
+		 */
+		enum class RemoteInputTransport
+		{
+			//! Listen on a Unix domain datagram socket
+			UnixSocket =     0x00000000,
+
+			//! Listen on a UDP socket bound to the loopback address
+			UDP =            0x00000001
+		};
+
+		//! Arguments for RemoteInput
+		struct RemoteInputArgs
+		{
+			//! Window that recieved events will be delivered to
+			Window* target = nullptr;
+
+			//! Socket type to listen on
+			RemoteInputTransport transport = RemoteInputTransport::UDP;
+
+			//! Filesystem path of the socket if using RemoteInputTransport::UnixSocket
+			std::string socketPath = "";
+
+			//! Loopback port to bind to if using RemoteInputTransport::UDP
+			Int port = 0;
+
+			/*!
+			 * \brief Time, in seconds, events are held back before being
+			 * delivered
+			 *
+			 * Events are delivered at the time they were sent, plus the
+			 * smallest transit time seen so far, plus this delay. Larger values
+			 * absorb more arrival jitter at the cost of latency.
+			 */
+			Double jitterBuffer = 0.008;
+		};
+
+		/*!
+		 * \brief Latency statistics for events recieved by RemoteInput
+		 *
+		 * All times are measured in seconds.
+		 */
+		struct RemoteInputStats
+		{
+			//! Number of events recieved
+			std::uint64_t recieved = 0;
+
+			//! Number of events delivered to the target window
+			std::uint64_t delivered = 0;
+
+			//! Number of datagrams discarded as malformed
+			std::uint64_t malformed = 0;
+
+			//! Number of events that arrived after their delivery time
+			std::uint64_t late = 0;
+
+			//! Smoothed arrival jitter, as described by RFC 3550
+			Double jitter = 0.0;
+
+			//! Mean time between an event arriving and being delivered
+			Double meanLatency = 0.0;
+
+			//! Largest time between an event arriving and being delivered
+			Double maxLatency = 0.0;
+		};
+
+		/*!
+		 * \brief Recieves input from another process over a local socket
+		 *
+		 * Decoded events are passed through the same GLFW callbacks real
+		 * input goes through, so Keyboard, Mouse and any event listeners
+		 * cannot tell them apart. Events that are due are queued in a
+		 * <tt>PreUpdateEvent</tt> and delivered along with input injected
+		 * through VLFWMain, in the same or the next frame. Datagrams holding
+		 * an unknown event type, a mouse button above
+		 * <tt>GLFW_MOUSE_BUTTON_LAST</tt> or an invalid action are
+		 * discarded as malformed. Events that become due after the target
+		 * window has been destroyed are discarded, see SetTarget().
+		 *
+		 * Each datagram holds a header followed by one or more events, all
+		 * fields are little-endian:
+		 *
+		 * \code
+		 * header:      u32 magic ('VLRI' = 0x49524C56), u64 send time (microseconds, sender's clock)
+		 * key:         u8 1, i32 key, i32 scancode, u8 action (0 release, 1 press, 2 repeat)
+		 * char:        u8 2, u32 codepoint
+		 * button:      u8 3, u8 button, u8 action (0 release, 1 press)
+		 * move:        u8 4, f32 x, f32 y
+		 * scroll:      u8 5, f32 x, f32 y
+		 * enter/leave: u8 6, u8 entered
+		 * \endcode
+		 *
+		 * Only supported on POSIX platforms.
+		 */
+		class RemoteInput final :
+			public EventListener<PreUpdateEvent>
+		{
+			public:
+			typedef std::chrono::steady_clock Clock;
+
+			private:
+			// A single decoded event, waiting in the jitter buffer
+			struct Pending
+			{
+				Clock::time_point arrival;
+				Clock::time_point due;
+				std::uint8_t type;
+				Int a, b, c;
+				Float x, y;
+			};
+
+			// The window may be destroyed before RemoteInput, so it is only
+			// compared against VLFWMain's table of live windows
+			Window* target;
+			std::uint64_t targetGeneration;
+			Window::WindowHandle targetHandle;
+			Double jitterBuffer;
+			int socket;
+			std::string socketPath;
+
+			std::thread reciever;
+			std::atomic_bool running;
+
+			std::mutex mtx;
+			std::deque<Pending> buffer;
+			RemoteInputStats stats;
+			bool haveOffset;
+			std::int64_t minOffset;
+			Double lastTransit;
+
+			void Recieve();
+			void Decode(const unsigned char* data, Size size, Clock::time_point arrival);
+			void Deliver(const Pending& p);
+
+			public:
+			RemoteInput(const RemoteInputArgs& args);
+
+			RemoteInput() = delete;
+			RemoteInput(const RemoteInput&) = delete;
+			RemoteInput(RemoteInput&&) = delete;
+			RemoteInput& operator=(const RemoteInput&) = delete;
+			RemoteInput& operator=(RemoteInput&&) = delete;
+			~RemoteInput();
+
+			void OnEvent(const PreUpdateEvent& ev) override;
+
+			/*!
+			 * \brief Gets latency statistics for recieved events
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			RemoteInputStats GetStats();
+
+			/*!
+			 * \brief Changes the window recieved events are delivered to
+			 *
+			 * Passing <tt>nullptr</tt> detaches RemoteInput from any window,
+			 * events keep being recieved but are discarded once due.
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void SetTarget(Window* window);
+
+			/*!
+			 * \brief Changes the jitter buffer delay
+			 *
+			 * \sa RemoteInputArgs::jitterBuffer
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void SetJitterBuffer(Double seconds);
+		};
+	}
+}
+
+#endif
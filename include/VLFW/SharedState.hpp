@@ -0,0 +1,161 @@
+#ifndef VLFW_SHARED_STATE_HPP
+#define VLFW_SHARED_STATE_HPP
+
+#include "InputSnapshot.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		/*!
+		 * \brief State of a single window, as published to shared memory
+		 */
+		struct SharedWindowState
+		{
+			//! Value of the window's handle, unique among live windows
+			std::uint64_t id;
+
+			//! Size of the window in screen units
+			Int width, height;
+
+			//! Size of the window's framebuffer in pixels
+			Int framebufferWidth, framebufferHeight;
+
+			//! Position of the window in screen coordinates
+			Int x, y;
+
+			//! Non-zero if the window has focus
+			std::uint8_t focused;
+
+			//! Non-zero if the window is minimized
+			std::uint8_t minimized;
+
+			//! Non-zero if the window is maximized
+			std::uint8_t maximized;
+
+			//! Non-zero if the window is visible
+			std::uint8_t visible;
+		};
+
+		/*!
+		 * \brief Everything VLFWMain publishes to shared memory each frame
+		 *
+		 * This struct is copied byte-for-byte between processes, so readers
+		 * must be built against the same version of VLFW as the publisher.
+		 */
+		struct SharedInputState
+		{
+			//! Maximum number of windows that can be published
+			static constexpr Size MaxWindows = 16;
+
+			//! Number of frames published so far
+			std::uint64_t frame;
+
+			//! Keyboard and mouse state
+			InputSnapshot input;
+
+			//! Number of valid entries in <tt>windows</tt>
+			std::uint32_t windowCount;
+
+			//! Per-window state
+			SharedWindowState windows[MaxWindows];
+		};
+
+		/*!
+		 * \brief Writes SharedInputState into a named POSIX shared memory
+		 * region, guarded by a sequence lock
+		 *
+		 * The region is created when the publisher is constructed and
+		 * unlinked when it is destroyed. Writes never block; readers retry
+		 * if they observe a write in progress.
+		 *
+		 * Usually constructed by VLFWMain when
+		 * VLFWMainArgs::sharedStateName is set.
+		 */
+		class SharedStatePublisher
+		{
+			void* region;
+			std::string name;
+
+			public:
+
+			/*!
+			 * \brief Creates the shared memory region
+			 *
+			 * \param name Name of the region. A leading '/' is added if
+			 * not present.
+			 *
+			 * Throws a std::runtime_error if the region could not be
+			 * created or shared memory is not supported on this platform.
+			 */
+			SharedStatePublisher(const std::string& name);
+
+			SharedStatePublisher() = delete;
+			SharedStatePublisher(const SharedStatePublisher&) = delete;
+			SharedStatePublisher(SharedStatePublisher&&) = delete;
+			SharedStatePublisher& operator=(const SharedStatePublisher&) = delete;
+			SharedStatePublisher& operator=(SharedStatePublisher&&) = delete;
+			~SharedStatePublisher();
+
+			/*!
+			 * \brief Publishes a new state
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void Publish(const SharedInputState& state);
+		};
+
+		/*!
+		 * \brief Reads SharedInputState published by another process
+		 *
+		 * This class does not depend on GLFW or VLFWMain and is built into
+		 * the standalone <tt>VLFWSharedState</tt> library, so tools need
+		 * not link against the rest of VLFW.
+		 */
+		class SharedStateReader
+		{
+			const void* region;
+
+			public:
+
+			/*!
+			 * \brief Opens an existing shared memory region for reading
+			 *
+			 * Throws a std::runtime_error if the region does not exist or
+			 * was published by an incompatible version of VLFW.
+			 */
+			SharedStateReader(const std::string& name);
+
+			SharedStateReader() = delete;
+			SharedStateReader(const SharedStateReader&) = delete;
+			SharedStateReader(SharedStateReader&&) = delete;
+			SharedStateReader& operator=(const SharedStateReader&) = delete;
+			SharedStateReader& operator=(SharedStateReader&&) = delete;
+			~SharedStateReader();
+
+			/*!
+			 * \brief Copies the latest consistent state into <tt>out</tt>
+			 *
+			 * \param maxAttempts Number of times to retry if a write was in
+			 * progress
+			 *
+			 * \returns false if no consistent state could be read within
+			 * <tt>maxAttempts</tt> attempts or nothing has been published
+			 * yet.
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			bool Read(SharedInputState& out, Size maxAttempts = 64) const;
+		};
+	}
+}
+
+#endif
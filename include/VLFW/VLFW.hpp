@@ -3,24 +3,38 @@
 
 #include "ValkyrieEngine/ValkyrieEngine.hpp"
 
+#include "Diagnostics.hpp"
+#include "FrameArena.hpp"
+#include "FramePacer.hpp"
+#include "InputSampler.hpp"
 #include "Keyboard.hpp"
 #include "Monitor.hpp"
 #include "Mouse.hpp"
+#include "RemoteInput.hpp"
+#include "SharedState.hpp"
 #include "Window.hpp"
 
 #include "ValkyrieEngine/EventBus.hpp"
 
+#include <memory>
 #include <mutex>
 
 namespace vlk
 {
 	namespace vlfw
 	{
-		//! Sent when GLFW generates an error
+		/*!
+		 * \brief Sent when GLFW generates an error
+		 *
+		 * Errors generated on the main thread are copied into VLFWMain's
+		 * frame arena and <tt>what</tt> is valid until the end of the frame.
+		 * Errors generated on other threads are sent on that thread and
+		 * <tt>what</tt> is only valid while the event is being sent.
+		 */
 		struct ErrorEvent
 		{
 			Int errorCode;
-			std::string what;
+			ArenaString what;
 		};
 
 		enum class WaitMode
@@ -29,7 +43,84 @@ namespace vlk
 			Wait =           0x00000000,
 
 			//! Update the window anyway, processing any events that have been posted
-			Poll =           0x00000001
+			Poll =           0x00000001,
+
+			/*!
+			 * \brief Poll while there is activity, wait once there has been
+			 * none for VLFWMainArgs::idlePeriod
+			 *
+			 * Input, window changes and redraw requests count as activity,
+			 * as does the application declaring itself animating with
+			 * VLFWMain::SetAnimating().
+			 */
+			Adaptive =       0x00000002
+		};
+
+		/*!
+		 * \brief How VLFWMain swaps the buffers of multiple OpenGL and
+		 * OpenGL ES windows
+		 */
+		enum class SwapMode
+		{
+			//! Swap each window in turn on the main thread
+			Sequential =     0x00000000,
+
+			/*!
+			 * \brief Swap all windows at once, each on its own thread
+			 *
+			 * Contexts are released from the main thread while swapping, the
+			 * context that was current beforehand is made current again
+			 * afterwards.
+			 */
+			Parallel =       0x00000001,
+
+			/*!
+			 * \brief Swap each window in turn, but only synchronize the
+			 * first window to vertical blank
+			 *
+			 * Overrides the swap interval of every window, see
+			 * VLFWMain::SetSwapInterval().
+			 */
+			PrimaryVsync =   0x00000002
+		};
+
+		/*!
+		 * \brief How VLFWMain waits for rendering to complete before
+		 * swapping buffers
+		 */
+		enum class RenderSyncMode
+		{
+			/*!
+			 * \brief Send a VLFWMain::RenderWaitEvent, listeners block until
+			 * rendering is complete
+			 */
+			Event =          0x00000000,
+
+			/*!
+			 * \brief Track each frame with an OpenGL sync object and only wait
+			 * when more than VLFWMainArgs::maxFramesInFlight frames are
+			 * still being processed
+			 *
+			 * No VLFWMain::RenderWaitEvent is sent. Requires OpenGL 3.2,
+			 * OpenGL ES 3.0 or ARB_sync, checked separately for each window's
+			 * context, other contexts swap without waiting. Windows without
+			 * an OpenGL or OpenGL ES context are not affected, VLFW does not
+			 * own a Vulkan device and so cannot wait on one.
+			 */
+			Fence =          0x00000001
+		};
+
+		//! Counters describing how VLFWMain processed window events
+		struct EventStats
+		{
+			//! Number of buffered events sent during the last frame
+			Size sent = 0;
+
+			//! Number of low priority events deferred from the last frame to the next
+			Size deferred = 0;
+
+			//! Total number of times any event has been deferred to a later frame
+			Size totalDeferred = 0;
 		};
 
 		//! Arguments for VLFWMain
@@ -41,8 +132,174 @@ namespace vlk
 			//! Max timeout when waiting for events
 			Double waitTimeout = 0.0;
 
-			//! Send a VLFWMain::RenderWaitEvent to wait for the renderer to complete before swapping buffers?
+			//! Time, in seconds, without activity before <tt>WaitMode::Adaptive</tt> starts waiting for events
+			Double idlePeriod = 0.5;
+
+			//! Send a VLFWMain::RenderWaitEvent to wait for the renderer to complete before swapping buffers? Ignored when using <tt>RenderSyncMode::Fence</tt>.
 			bool waitForRenderer = true;
+
+			//! How to swap the buffers of multiple windows
+			SwapMode swapMode = SwapMode::Sequential;
+
+			//! How to wait for rendering to complete before swapping buffers
+			RenderSyncMode renderSyncMode = RenderSyncMode::Event;
+
+			/*!
+			 * \brief Maximum number of frames the GPU may lag behind when
+			 * using <tt>RenderSyncMode::Fence</tt>
+			 */
+			Size maxFramesInFlight = 2;
+
+			/*!
+			 * \brief Render and swap buffers on a thread owned by VLFWMain
+			 *
+			 * The main thread only processes events and applies window
+			 * changes, then hands each frame to the render thread without
+			 * waiting for it. If the render thread is still busy, only the
+			 * latest frame is rendered.
+			 *
+			 * The render thread makes each window's context current in turn
+			 * and passes a VLFWMain::RenderEvent, then a
+			 * VLFWMain::RenderWaitEvent if requested, to every
+			 * VLFWMain::RenderListener, then swaps buffers. These are not
+			 * sent through ValkyrieEngine's event bus. The main thread releases the context of any window it creates, and
+			 * destroying a window waits for the current frame to finish.
+			 * <tt>swapMode</tt> is ignored, windows are swapped in turn.
+			 */
+			bool renderThread = false;
+
+			/*!
+			 * \brief Delay the start of each frame so it finishes just
+			 * before the next vertical blank
+			 *
+			 * Has no effect when using a render thread.
+			 *
+			 * \sa FramePacer
+			 */
+			bool framePacing = false;
+
+			//! Arguments for the FramePacer used if <tt>framePacing</tt> is set
+			FramePacerArgs framePacer = {};
+
+			/*!
+			 * \brief Only redraw windows that have changed
+			 *
+			 * Windows are marked for redrawing when refreshed, resized,
+			 * focused, restored, when they recieve input, or by
+			 * Window::RequestRedraw(). Buffers are only swapped for marked
+			 * windows, and VLFWMain::RenderWaitEvent is only sent if there
+			 * is at least one. When no window is marked, VLFWMain waits for
+			 * events regardless of <tt>waitMode</tt>.
+			 *
+			 * While the application is animating, every window is redrawn.
+			 *
+			 * \sa Window::NeedsRedraw(), VLFWMain::SetAnimating()
+			 */
+			bool redrawOnDemand = false;
+
+			/*!
+			 * \brief Process events that arrived during the frame again
+			 * right before swapping buffers, and send a
+			 * VLFWMain::LateLatchEvent for each window being redrawn
+			 *
+			 * Listeners can use the freshest cursor position to adjust what
+			 * is about to be presented, for example updating a camera's view
+			 * matrix, before VLFWMain::RenderWaitEvent is sent. Events
+			 * processed here are held back and sent during the next
+			 * <tt>PreUpdateEvent</tt>, in order with the events processed
+			 * then, so Keyboard, Mouse and listeners see them in the next
+			 * frame. Window state cached by Window is updated immediately.
+			 *
+			 * Ignored when using a render thread.
+			 */
+			bool lateLatch = false;
+
+			/*!
+			 * \brief Time, in seconds, to keep processing events while they
+			 * are still arriving when using <tt>lateLatch</tt>
+			 *
+			 * Pending events are always processed at least once.
+			 */
+			Double lateLatchBudget = 0.001;
+
+			/*!
+			 * \brief Time, in seconds, that may be spent sending window
+			 * events each frame, or 0 to send every event as soon as it is
+			 * recieved
+			 *
+			 * When set, window events are buffered while GLFW processes
+			 * events and sent afterwards. Key, character, mouse button,
+			 * focus, minimize, maximize, close and cursor enter events are
+			 * sent first and are never deferred, but count against the
+			 * budget. Movement, resize, refresh, scroll and file drop events
+			 * are then sent in order until the budget runs out, the rest are
+			 * deferred to the next frame. At least one low priority event is
+			 * sent each frame.
+			 *
+			 * Cursor movement buffered for a window is merged into one
+			 * Window::MouseMoveEvent with the latest position. A mouse button
+			 * event first sends that position, so clicks are not delivered at
+			 * a stale cursor position.
+			 *
+			 * This bounds the time sending a flood of events to listeners
+			 * can take from a frame, at the cost of delivering some events
+			 * late and out of order relative to high priority events. The
+			 * time GLFW spends processing events is not bounded. Cached
+			 * window state is always up to date, and VLFWMain polls rather
+			 * than waits while events are deferred.
+			 *
+			 * \sa VLFWMain::GetEventStats()
+			 */
+			Double eventBudget = 0.0;
+
+			/*!
+			 * \brief Send a Window::TextInputEvent with all the characters
+			 * typed into a window each time events are processed, instead of
+			 * a Window::CharTypeEvent per character
+			 *
+			 * Text is sent after the other events processed at the same time,
+			 * so it may arrive after key events for keys pressed later.
+			 */
+			bool batchTextInput = false;
+
+			/*!
+			 * \brief Map files dropped onto windows into memory and read
+			 * them in on a background thread, then send a
+			 * Window::FileDropReadyEvent
+			 *
+			 * Lets applications import large files without reading them on
+			 * the main thread. Window::FileDropEvent is still sent as soon as
+			 * files are dropped.
+			 */
+			bool mapDroppedFiles = false;
+
+			/*!
+			 * \brief Collect GLFW errors, OpenGL debug output and Vulkan
+			 * validation messages and send them as DiagnosticEvent%s at the
+			 * end of each frame
+			 *
+			 * Messages may arrive on any thread, they are copied into a
+			 * lock-free buffer and sent from the main thread during a
+			 * <tt>PostUpdateEvent</tt>. Repeated messages are rate limited,
+			 * see DiagnosticsArgs. GLFW errors are then sent as ErrorEvent%s
+			 * at the end of the frame rather than as they happen.
+			 */
+			bool diagnostics = false;
+
+			//! Arguments for the diagnostics pipeline, used when diagnostics is true
+			DiagnosticsArgs diagnosticsArgs = {};
+
+			/*!
+			 * \brief Name of a shared memory region to publish input and
+			 * window state to each frame, or an empty string to disable
+			 * publication.
+			 *
+			 * Other processes may read the published state with a
+			 * SharedStateReader.
+			 *
+			 * \sa SharedStatePublisher
+			 */
+			std::string sharedStateName = "";
 		};
 
 		/*!
@@ -64,6 +321,28 @@ namespace vlk
 			public EventListener<vlk::PostUpdateEvent>
 		{
 			std::unique_lock<std::mutex> lock;
+			std::unique_ptr<SharedStatePublisher> publisher;
+			std::unique_ptr<FramePacer> pacer;
+			bool animating;
+			Double lastActivity;
+			SharedInputState sharedState;
+			CommandQueue postedEvents;
+			EventStats eventStats;
+			FrameArena frameArena;
+
+			void PublishSharedState();
+			void DeliverInjectedInput();
+			void CloseRequestedWindows();
+			void SwapWindowBuffers();
+			void SubmitRenderFrame();
+			void FireTimers();
+			void LatchLateInput();
+			void NotifyEventPosted();
+			void SendBufferedEvents();
+			void ResetFrameArena();
+			void SendTextInput();
+			void UpdateThrottling();
+			void FinishRedraw();
 
 			public:
 	
@@ -72,16 +351,103 @@ namespace vlk
 			 *
 			 * Listeners of this event should block the calling thread until
 			 * any pending rendering is completed and the default framebuffer
-			 * is ready to swap.
+			 * is ready to swap. When using a render thread, it is passed to
+			 * RenderListener::OnRenderWait() instead.
 			 *
 			 * \sa VLFWMainArgs::waitForRenderer
 			 */
 			struct RenderWaitEvent
 			{ };
 
+			/*!
+			 * \brief Passed to RenderListener::OnRender() by the render
+			 * thread for each window that should be drawn, with the window's
+			 * context current.
+			 *
+			 * Only used with a render thread.
+			 *
+			 * \sa VLFWMainArgs::renderThread
+			 */
+			struct RenderEvent
+			{
+				Window* window;
+			};
+
+			/*!
+			 * \brief Recieves the render thread's events
+			 *
+			 * The render thread does not send events through ValkyrieEngine,
+			 * whose listeners the main thread keeps sending to, adding and
+			 * removing at the same time. Each frame is instead passed to
+			 * every constructed RenderListener while holding a lock, which
+			 * constructing and destroying a listener also take.
+			 *
+			 * \sa VLFWMainArgs::renderThread
+			 *
+			 * \ts
+			 * Listeners may be constructed and destroyed on any thread, but
+			 * not from within a RenderListener callback.<br>
+			 * Access to this class is synchronized.<br>
+			 * Constructing or destroying a listener blocks the calling thread
+			 * until the frame being rendered has finished.<br>
+			 */
+			class RenderListener
+			{
+				public:
+				RenderListener();
+				virtual ~RenderListener();
+
+				RenderListener(const RenderListener&) = delete;
+				RenderListener(RenderListener&&) = delete;
+				RenderListener& operator=(const RenderListener&) = delete;
+				RenderListener& operator=(RenderListener&&) = delete;
+
+				//! Called on the render thread for each window that should be drawn
+				virtual void OnRender(const RenderEvent& ev) = 0;
+
+				//! Called on the render thread before swapping buffers, if VLFWMainArgs::waitForRenderer is set
+				virtual void OnRenderWait(const RenderWaitEvent& ev);
+			};
+
+			/*!
+			 * \brief Sent right before swapping the buffers of a window
+			 * being redrawn, after processing any events that arrived during
+			 * the frame
+			 *
+			 * Events from that processing are sent in the next frame, so
+			 * Keyboard and Mouse state does not include them yet.
+			 *
+			 * \sa VLFWMainArgs::lateLatch
+			 */
+			struct LateLatchEvent
+			{
+				Window* window;
+
+				//! Position of the cursor relative to the window's content area
+				Vector2 cursorPosition;
+			};
+
+			/*!
+			 * \brief Sent on the main thread when a timer expires
+			 *
+			 * \sa AddTimer()
+			 */
+			struct TimerEvent
+			{
+				//! ID returned by AddTimer()
+				Size id;
+			};
+
 			bool waitForRenderer;
 			Double waitTimeout;
+			Double idlePeriod;
 			WaitMode waitMode;
+			SwapMode swapMode;
+			bool redrawOnDemand;
+			bool lateLatch;
+			Double lateLatchBudget;
+			Double eventBudget;
+			bool batchTextInput;
 
 			inline VLFWMain() : VLFWMain(VLFWMainArgs{}) {}
 			VLFWMain(const VLFWMainArgs& args);
@@ -103,14 +469,137 @@ namespace vlk
 			 */
 			void SendEmptyEvent();
 
+			/*!
+			 * \brief Sends an event on the main thread
+			 *
+			 * The event is copied into a lock-free queue, and VLFWMain is
+			 * woken if it is waiting for events. Posted events are sent
+			 * during the next <tt>PreUpdateEvent</tt>, right after window
+			 * events have been processed, in the order they were posted.
+			 *
+			 * \code
+			 * struct AssetLoadedEvent { std::string path; };
+			 *
+			 * // On a worker thread
+			 * vlfwMain->PostEvent(AssetLoadedEvent{path});
+			 * \endcode
+			 *
+			 * Events that have not been sent when VLFWMain is destroyed are
+			 * discarded.
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			template<typename T>
+			void PostEvent(const T& ev)
+			{
+				postedEvents.Push([ev]() { SendEvent(ev); });
+				NotifyEventPosted();
+			}
+
 			/*!
 			 * \brief Sets the swap interval to use when swapping buffers of
 			 * the current OpenGL context.
 			 *
-			 * \sa VLFWMainArgs::swapInterval
+			 * This is overridden for every window when using
+			 * <tt>SwapMode::PrimaryVsync</tt>.
+			 *
+			 * \sa VLFWMainArgs::swapMode
 			 */
 			void SetSwapInterval(Int interval);
 
+			/*!
+			 * \brief Starts a timer that sends a TimerEvent when it expires
+			 *
+			 * Timers are checked after events are processed each frame. When
+			 * waiting for events, VLFWMain wakes up in time for the next
+			 * timer, so timers can drive periodic work such as blinking a
+			 * text cursor without polling.
+			 *
+			 * \param delay Seconds until the timer first expires
+			 * \param period Seconds between subsequent expiries, or 0 for a
+			 * timer that only expires once. Periods missed entirely, for
+			 * example during a long frame, are skipped.
+			 *
+			 * \returns An ID identifying the timer in TimerEvent and
+			 * CancelTimer()
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			Size AddTimer(Double delay, Double period = 0.0);
+
+			/*!
+			 * \brief Stops a timer
+			 *
+			 * Does nothing if the timer has already expired or been
+			 * cancelled.
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void CancelTimer(Size id);
+
+			/*!
+			 * \brief Gets the frame pacer used by VLFWMain
+			 *
+			 * \returns <tt>nullptr</tt> if VLFWMainArgs::framePacing was not
+			 * set
+			 */
+			inline FramePacer* GetFramePacer() { return pacer.get(); }
+
+			/*!
+			 * \brief Declares whether the application is animating
+			 *
+			 * While animating, <tt>WaitMode::Adaptive</tt> keeps polling for
+			 * events even if there is no other activity, and
+			 * VLFWMainArgs::redrawOnDemand redraws every window.
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void SetAnimating(bool animating);
+
+			//! Returns true if the application has declared itself animating
+			inline bool IsAnimating() const { return animating; }
+
+			/*!
+			 * \brief Gets counters describing how window events were
+			 * processed
+			 *
+			 * Only events buffered when using VLFWMainArgs::eventBudget are
+			 * counted.
+			 */
+			inline const EventStats& GetEventStats() const { return eventStats; }
+
+			/*!
+			 * \brief Gets the number of diagnostic messages dropped because
+			 * too many arrived in one frame
+			 *
+			 * \sa DiagnosticsArgs::capacity
+			 */
+			Size GetDroppedDiagnosticCount() const;
+
+			/*!
+			 * \brief Gets the arena that event payloads are allocated from
+			 *
+			 * The arena is reset at the end of each frame, during a
+			 * <tt>PostUpdateEvent</tt>. Applications may also use it for
+			 * their own per-frame allocations on the main thread. If events
+			 * have been deferred to a later frame, the frame's allocations
+			 * are handed to a spare arena until they have been sent, so the
+			 * arena is still reset every frame.
+			 */
+			inline FrameArena& GetFrameArena() { return frameArena; }
+
 			/*!
 			 * \brief Returns true if vulkan is at least minimally supported
 			 *
@@ -137,6 +626,20 @@ namespace vlk
 			 */
 			std::string GetClipboard() const;
 
+			/*!
+			 * \brief Gets the contents of the system clipboard, copied into
+			 * the frame arena
+			 *
+			 * Unlike GetClipboard(), this does not allocate from the general
+			 * heap. The string is valid until the end of the frame.
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			ArenaString GetClipboardText();
+
 			/*!
 			 * \brief Writes to the system clipboard
 			 *
@@ -148,6 +651,123 @@ namespace vlk
 			 * This function will not block the calling thread.<br>
 			 */
 			void SetClipboard(const std::string& data);
+
+			/*!
+			 * \brief Queues a synthetic key press for a window
+			 *
+			 * Injected input is delivered during the next
+			 * <tt>PreUpdateEvent</tt>, after real input has been processed,
+			 * and goes through exactly the same callbacks as real input.
+			 * Keyboard, Mouse and any event listeners cannot tell the two
+			 * apart. Input injected for a window that is destroyed before it
+			 * is delivered is discarded.
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void InjectKeyDown(Window* window, Key key, Int scancode = 0);
+
+			/*!
+			 * \brief Queues a synthetic key release for a window
+			 *
+			 * \sa InjectKeyDown()
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void InjectKeyUp(Window* window, Key key, Int scancode = 0);
+
+			/*!
+			 * \brief Queues a synthetic key repeat for a window
+			 *
+			 * \sa InjectKeyDown()
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void InjectKeyRepeat(Window* window, Key key, Int scancode = 0);
+
+			/*!
+			 * \brief Queues a synthetic Unicode character for a window
+			 *
+			 * \sa InjectKeyDown()
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void InjectChar(Window* window, UInt codepoint);
+
+			/*!
+			 * \brief Queues a synthetic mouse button press for a window
+			 *
+			 * \sa InjectKeyDown()
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void InjectMouseButtonDown(Window* window, MouseButton button);
+
+			/*!
+			 * \brief Queues a synthetic mouse button release for a window
+			 *
+			 * \sa InjectKeyDown()
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void InjectMouseButtonUp(Window* window, MouseButton button);
+
+			/*!
+			 * \brief Queues a synthetic cursor movement for a window
+			 *
+			 * \param position New cursor position in screen coordinates,
+			 * relative to the upper-left corner of the window's content
+			 * area.
+			 *
+			 * \sa InjectKeyDown()
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void InjectMouseMove(Window* window, Vector2 position);
+
+			/*!
+			 * \brief Queues a synthetic scroll for a window
+			 *
+			 * \sa InjectKeyDown()
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void InjectScroll(Window* window, Vector2 delta);
+
+			/*!
+			 * \brief Queues a synthetic cursor enter or leave for a window
+			 *
+			 * \sa InjectKeyDown()
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function may block the calling thread.<br>
+			 */
+			void InjectCursorEnter(Window* window, bool entered);
 		};
 	}
 }
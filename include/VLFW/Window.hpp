@@ -1,10 +1,18 @@
 #ifndef VLFW_WINDOW_HPP
 #define VLFW_WINDOW_HPP
 
+#include "CommandQueue.hpp"
+#include "FrameArena.hpp"
+#include "MappedFile.hpp"
 #include "Input.hpp"
 #include "Monitor.hpp"
 #include "Cursor.hpp"
+#include <deque>
+#include <functional>
+#include <memory>
 #include <type_traits>
+#include <typeindex>
+#include <unordered_map>
 
 namespace vlk
 {
@@ -113,6 +121,19 @@ namespace vlk
 			Locked =         0x00034003
 		};
 
+		//! How VLFWMain redraws a window while it is minimized, hidden or unfocused
+		enum class ThrottlePolicy
+		{
+			//! Redraw the window as normal
+			Continue =       0x00000000,
+
+			//! Stop redrawing the window
+			Pause =          0x00000001,
+
+			//! Redraw the window at most WindowHints::throttleRate times per second
+			Cap =            0x00000002
+		};
+
 		/*!
 		 * \brief Struct containing various hints to influence the creation and
 		 * initial state of a window object.
@@ -325,16 +346,67 @@ namespace vlk
 
 			//! Raise ValkyrieEngine's stop flag when destroyed
 			bool raiseStopOnClose =         true;
+
+			/*!
+			 * \brief Record calls to SetTitle(), SetSize(), SetPosition(),
+			 * SetOpacity() and SetCursorMode() and apply them once per frame
+			 *
+			 * Only the last value set during a frame is applied, and values
+			 * that match the window's current state are skipped. A size or
+			 * position is also not requested again until the window reports
+			 * a size or position of its own, so a request that is denied or
+			 * clamped is not repeated every frame. Changes are
+			 * applied by VLFWMain during a <tt>PostUpdateEvent</tt>, or by
+			 * calling Window::FlushPendingWrites().
+			 */
+			bool deferredWrites =           false;
+
+			/*!
+			 * \brief Minimum time, in seconds, between title changes when
+			 * using deferred writes
+			 *
+			 * Titles set more often than this are held back until the
+			 * interval has passed, only the latest title is applied.
+			 */
+			Double titleUpdateInterval =    0.0;
+
+			/*!
+			 * \brief How to redraw the window while minimized
+			 *
+			 * Swapping the buffers of a minimized window can block with vsync
+			 * enabled on some platforms.
+			 */
+			ThrottlePolicy minimizedThrottle = ThrottlePolicy::Pause;
+
+			//! How to redraw the window while hidden
+			ThrottlePolicy hiddenThrottle =    ThrottlePolicy::Pause;
+
+			//! How to redraw the window while it does not have input focus
+			ThrottlePolicy unfocusedThrottle = ThrottlePolicy::Continue;
+
+			//! Maximum redraws per second for windows using <tt>ThrottlePolicy::Cap</tt>
+			Double throttleRate =           10.0;
 		};
 
+		struct WindowAccess;
+
 		/*!
 		 * \brief Window wrapper class
 		 *
 		 * Certain functions of this class require an instance of VLFWMain to
 		 * be constructed prior in order to function properly.
+		 *
+		 * The size, framebuffer size, position, content scale, focus,
+		 * maximized, minimized and visible states of the window are cached
+		 * and updated as window events are processed, so querying them does
+		 * not go through GLFW. Changes requested through this class are
+		 * reflected once the resulting event has been processed, use
+		 * Refresh() to synchronize the cache immediately.
 		 */
 		class Window
 		{
+			friend struct WindowAccess;
+
 			public:
 			typedef void* WindowHandle;
 
@@ -404,6 +476,18 @@ namespace vlk
 				Window* window;
 			};
 
+			/*!
+			 * \brief Sent when the throttle policy applied to a window
+			 * changes
+			 *
+			 * \sa GetThrottlePolicy()
+			 */
+			struct ThrottleEvent
+			{
+				Window* window;
+				ThrottlePolicy policy;
+			};
+
 			//! Sent when the cursor enters the area of a window
 			struct CursorEnterEvent
 			{
@@ -529,6 +613,32 @@ namespace vlk
 				char32_t codepoint;
 			};
 
+			/*!
+			 * \brief Sent instead of CharTypeEvent with every character typed
+			 * into a window while events were processed
+			 *
+			 * Text is allocated from VLFWMain's frame arena and is valid until
+			 * the end of the frame.
+			 *
+			 * \sa VLFWMainArgs::batchTextInput
+			 */
+			struct TextInputEvent
+			{
+				/*!
+				 * \brief The window object that recieved this event.
+				 */
+				Window* window;
+
+				//! UTF-32 codepoints of the typed characters, in order
+				const char32_t* codepoints;
+
+				//! Number of elements in <tt>codepoints</tt>
+				Size codepointCount;
+
+				//! The typed characters, UTF-8 encoded
+				ArenaString utf8;
+			};
+
 			/*!
 			 * \brief Sent when a file or directory is 'dropped' onto the window.
 			 */
@@ -541,14 +651,145 @@ namespace vlk
 
 				/*!
 				 * \brief UTF-8 encoded paths that were dropped on the window.
+				 *
+				 * Allocated from VLFWMain's frame arena, valid until the end
+				 * of the frame. Without a VLFWMain, only valid while the
+				 * event is being sent.
+				 */
+				const ArenaString* paths;
+
+				//! Number of elements in <tt>paths</tt>
+				Size pathCount;
+			};
+
+			/*!
+			 * \brief Sent once files dropped onto the window have been
+			 * mapped and read into memory
+			 *
+			 * Sent on the main thread some time after the matching
+			 * FileDropEvent. Not sent if the window is destroyed first. The
+			 * files have been prefetched with MappedFile::Prefetch(), so
+			 * reading them does not wait on disk unless pages were evicted
+			 * in the meantime.
+			 *
+			 * \sa VLFWMainArgs::mapDroppedFiles
+			 */
+			struct FileDropReadyEvent
+			{
+				/*!
+				 * \brief The window object that recieved this event.
+				 */
+				Window* window;
+
+				/*!
+				 * \brief Read-only mappings of the dropped files
+				 *
+				 * Each file stays mapped for as long as a reference to it is
+				 * kept.
 				 */
-				std::vector<std::string> paths;
+				std::vector<std::shared_ptr<const MappedFile>> files;
+
+				//! UTF-8 encoded paths that could not be mapped, such as directories
+				std::vector<std::string> failedPaths;
 			};
 
 			private:
+			// Attributes updated from window callbacks
+			struct CachedState
+			{
+				Point<Int> size;
+				Point<Int> framebufferSize;
+				Point<Int> position;
+				Vector2 contentScale;
+				bool focused;
+				bool maximized;
+				bool minimized;
+				bool visible;
+			};
+
+			// Values recorded by setters when using deferred writes
+			struct PendingWrites
+			{
+				UInt dirty;
+				std::string title;
+				Point<Int> size;
+				Point<Int> position;
+				Float opacity;
+				CursorMode cursorMode;
+
+				// Size and position last requested from GLFW, valid while
+				// their bit is set. Cleared when the window reports a new
+				// size or position, a denied request reports nothing.
+				UInt requested;
+				Point<Int> requestedSize;
+				Point<Int> requestedPosition;
+			};
+
 			WindowHandle handle;
 			bool raiseStopOnClose;
 			ContextAPI contextAPI;
+			CachedState cache;
+
+			bool deferredWrites;
+			Double titleUpdateInterval;
+			Double lastTitleUpdate;
+			std::string title;
+			Float opacity;
+			CursorMode cursorMode;
+			PendingWrites pending;
+			CommandQueue commands;
+
+			ThrottlePolicy minimizedThrottle;
+			ThrottlePolicy hiddenThrottle;
+			ThrottlePolicy unfocusedThrottle;
+			Double throttleRate;
+
+			// Index of this window in VLFWMain's window table
+			Size tableIndex;
+
+			// Handlers registered with Subscribe(), keyed by event type. A
+			// deque keeps handlers in place while subscribing from a handler,
+			// and unsubscribing during delivery only deactivates the entry
+			// until delivery finishes.
+			struct Subscription
+			{
+				Size id;
+				bool active;
+				std::function<void(const void*)> handler;
+			};
+
+			std::unordered_map<std::type_index, std::deque<Subscription>> subscriptions;
+			Size nextSubscriptionID;
+			Size deliveryDepth;
+			bool subscriptionsRemoved;
+
+			void RemoveUnsubscribed();
+
+			// Calls handlers subscribed to events of type T
+			template<typename T>
+			void Deliver(const T& ev)
+			{
+				if (subscriptions.empty()) return;
+
+				auto it = subscriptions.find(std::type_index(typeid(T)));
+				if (it == subscriptions.end()) return;
+
+				// References to map elements survive a rehash, iterators do
+				// not. Handlers subscribed during delivery are not called
+				// until the next event.
+				const std::deque<Subscription>& subs = it->second;
+				Size count = subs.size();
+
+				deliveryDepth++;
+				for (Size i = 0; i < count; i++)
+				{
+					const Subscription& sub = subs[i];
+					if (sub.active) sub.handler(&ev);
+				}
+				deliveryDepth--;
+
+				if (deliveryDepth == 0 && subscriptionsRemoved) RemoveUnsubscribed();
+			}
 
 			public:
 
@@ -758,6 +999,182 @@ namespace vlk
 			 */
 			void SetTitle(const std::string& title);
 
+			/*!
+			 * \brief Applies any changes recorded while using deferred
+			 * writes
+			 *
+			 * Called by VLFWMain once per frame, changes held back by
+			 * WindowHints::titleUpdateInterval remain pending.
+			 *
+			 * \sa WindowHints::deferredWrites
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void FlushPendingWrites();
+
+			/*!
+			 * \brief Returns true if changes recorded while using deferred
+			 * writes have not been applied yet
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			inline bool HasPendingWrites() const { return pending.dirty != 0; }
+
+			/*!
+			 * \brief Queues a function to be called with this window on the
+			 * main thread
+			 *
+			 * Use this to call any of this class's main-thread-only functions
+			 * from another thread. Posted functions are called in order at
+			 * the start of the next <tt>PreUpdateEvent</tt>, before events
+			 * are processed, and will wake VLFWMain if it is waiting for
+			 * events.
+			 *
+			 * \code
+			 * window->Post([](Window& w) { w.SetTitle("Loading complete"); });
+			 * \endcode
+			 *
+			 * Functions that have not been called when the window is
+			 * destroyed are discarded. The caller must ensure the window is
+			 * not destroyed while this function is executing.
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void Post(std::function<void(Window&)> command);
+
+			/*!
+			 * \brief Calls any functions queued with Post()
+			 *
+			 * Called by VLFWMain at the start of each frame.
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void ExecutePosted();
+
+			/*!
+			 * \brief Calls a function for each event of type T sent for
+			 * this window
+			 *
+			 * T may be any event with a <tt>window</tt> member that VLFW
+			 * sends, such as Window::KeyDownEvent. Unlike an EventListener,
+			 * which recieves events for every window and has to check
+			 * <tt>ev.window</tt> itself, a subscription only recieves events
+			 * for this window, so the cost of sending an event depends on
+			 * the number of subscriptions to that window. Subscriptions are
+			 * called after event listeners.
+			 *
+			 * \code
+			 * window->Subscribe<Window::KeyDownEvent>([](const Window::KeyDownEvent& ev)
+			 * {
+			 *     // Only key presses in this window
+			 * });
+			 * \endcode
+			 *
+			 * Event listeners may destroy the window, its subscriptions are
+			 * then not called. Handlers themselves must not destroy the
+			 * window.
+			 *
+			 * \returns An ID that can be passed to Unsubscribe()
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			template<typename T>
+			Size Subscribe(std::function<void(const T&)> handler)
+			{
+				Size id = nextSubscriptionID++;
+
+				subscriptions[std::type_index(typeid(T))].push_back(Subscription{
+					id,
+					true,
+					[handler](const void* ev) { handler(*static_cast<const T*>(ev)); }
+				});
+
+				return id;
+			}
+
+			/*!
+			 * \brief Removes a function added with Subscribe()
+			 *
+			 * May be called from a subscribed handler. Does nothing if the
+			 * subscription has already been removed.
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void Unsubscribe(Size id);
+
+			/*!
+			 * \brief Requests that this window is redrawn this frame
+			 *
+			 * Only needed when using VLFWMainArgs::redrawOnDemand. Windows
+			 * are also marked for redrawing when refreshed, resized, focused,
+			 * restored or when they recieve input. Also counts as activity
+			 * for <tt>WaitMode::Adaptive</tt>.
+			 *
+			 * To request a redraw from another thread, use Post().
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void RequestRedraw();
+
+			/*!
+			 * \brief Returns true if this window will be swapped this frame
+			 *
+			 * Always true unless using VLFWMainArgs::redrawOnDemand or the
+			 * window is throttled. Applications may skip rendering windows
+			 * that do not need redrawing.
+			 *
+			 * \sa GetThrottlePolicy()
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			bool NeedsRedraw() const;
+
+			/*!
+			 * \brief Gets the throttle policy that applies to the window in
+			 * its current state
+			 *
+			 * Minimized takes precedence over hidden, which takes precedence
+			 * over unfocused.
+			 *
+			 * \sa WindowHints::minimizedThrottle, ThrottleEvent
+			 *
+			 * \ts
+			 * This function may be called from any thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			ThrottlePolicy GetThrottlePolicy() const;
+
+			//! Returns true if the window is redrawn less often than normal
+			inline bool IsThrottled() const { return GetThrottlePolicy() != ThrottlePolicy::Continue; }
+
+			//! Gets the maximum redraws per second while using <tt>ThrottlePolicy::Cap</tt>
+			inline Double GetThrottleRate() const { return throttleRate; }
+
 			/*!
 			 * \brief Gets the monitor the window is fullscreen on
 			 *
@@ -913,6 +1330,22 @@ namespace vlk
 			 */
 			void Notify();
 
+			/*!
+			 * \brief Queries GLFW for the window's current size, position,
+			 * content scale and state, updating the cached values returned
+			 * by getters.
+			 *
+			 * This is only necessary if a change made through this class must
+			 * be observed before the next call to PollEvents() or
+			 * WaitEvents().
+			 *
+			 * \ts
+			 * This function must only be called from the main thread.<br>
+			 * Access to this class is not synchronized.<br>
+			 * This function will not block the calling thread.<br>
+			 */
+			void Refresh();
+
 			/*!
 			 * \brief Returns true if the window is transparent
 			 *
@@ -0,0 +1,106 @@
+#include "VLFW/CommandQueue.hpp"
+
+#include <memory>
+
+using namespace vlk;
+using namespace vlfw;
+
+// Intrusive MPSC queue after Dmitry Vyukov. Producers only ever exchange the
+// head pointer, the consumer walks from the tail and uses a stub node so the
+// queue is never truly empty.
+
+CommandQueue::CommandQueue() :
+	head(&stub),
+	tail(&stub)
+{
+	stub.next.store(nullptr, std::memory_order_relaxed);
+}
+
+CommandQueue::~CommandQueue()
+{
+	Node* n;
+	while ((n = PopNode()) != nullptr) delete n;
+}
+
+void CommandQueue::PushNode(Node* n)
+{
+	n->next.store(nullptr, std::memory_order_relaxed);
+	Node* prev = head.exchange(n, std::memory_order_acq_rel);
+
+	// Between these two lines the queue is briefly disconnected, the
+	// consumer treats that as empty and picks n up on its next call
+	prev->next.store(n, std::memory_order_release);
+}
+
+CommandQueue::Node* CommandQueue::PopNode()
+{
+	Node* t = tail;
+	Node* next = t->next.load(std::memory_order_acquire);
+
+	if (t == &stub)
+	{
+		if (next == nullptr) return nullptr;
+
+		tail = next;
+		t = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+
+	if (next != nullptr)
+	{
+		tail = next;
+		return t;
+	}
+
+	// t is the last node, a push is in progress if head has moved on
+	if (t != head.load(std::memory_order_acquire)) return nullptr;
+
+	// Put the stub back behind t so t can be removed
+	PushNode(&stub);
+
+	next = t->next.load(std::memory_order_acquire);
+	if (next != nullptr)
+	{
+		tail = next;
+		return t;
+	}
+
+	return nullptr;
+}
+
+void CommandQueue::Push(std::function<void()> command)
+{
+	Node* n = new Node();
+	n->command = std::move(command);
+	PushNode(n);
+}
+
+Size CommandQueue::Execute()
+{
+	// Stop at the newest node present now, commands pushed while
+	// executing, including by the commands themselves, are left for the
+	// next call. The newest node may be the stub, put back by an earlier
+	// call while a producer was pushing, with commands still queued ahead
+	// of it. Those are executed until the stub reaches the tail.
+	Node* last = head.load(std::memory_order_acquire);
+
+	Size count = 0;
+	Node* n;
+
+	while (!(last == &stub && tail == &stub) && (n = PopNode()) != nullptr)
+	{
+		std::unique_ptr<Node> owned(n);
+		owned->command();
+		count++;
+
+		if (n == last) break;
+	}
+
+	return count;
+}
+
+bool CommandQueue::IsEmpty() const
+{
+	return tail == &stub && stub.next.load(std::memory_order_acquire) == nullptr &&
+		head.load(std::memory_order_acquire) == &stub;
+}
@@ -0,0 +1,346 @@
+#include "VLFW/Diagnostics.hpp"
+#include "Internal.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define VLFW_GLAPI __stdcall
+#else
+#define VLFW_GLAPI
+#endif
+
+using namespace vlk;
+using namespace vlfw;
+
+namespace
+{
+	// Longest message stored, longer messages are truncated
+	constexpr Size maxMessageLength = 511;
+
+	struct Record
+	{
+		std::atomic<Size> sequence;
+		DiagnosticSource source;
+		DiagnosticSeverity severity;
+		std::int64_t id;
+		std::uint32_t category;
+		Size length;
+		char text[maxMessageLength + 1];
+	};
+
+	// Bounded lock-free queue after Dmitry Vyukov. Any thread may push,
+	// only the main thread pops. Each slot's sequence number says whether it
+	// is free for the producer at a position or filled for the consumer.
+	class DiagnosticRing
+	{
+		std::unique_ptr<Record[]> records;
+		Size mask;
+		std::atomic<Size> pushPos;
+		Size popPos;
+
+		public:
+		std::atomic<Size> dropped;
+
+		DiagnosticRing(Size capacity) :
+			pushPos(0),
+			popPos(0),
+			dropped(0)
+		{
+			Size size = 2;
+			while (size < capacity) size *= 2;
+
+			records.reset(new Record[size]);
+			mask = size - 1;
+
+			for (Size i = 0; i < size; i++)
+			{
+				records[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		bool Push(DiagnosticSource source, DiagnosticSeverity severity, std::int64_t id,
+			std::uint32_t category, const char* text, Size length)
+		{
+			Size pos = pushPos.load(std::memory_order_relaxed);
+			Record* r;
+
+			while (true)
+			{
+				r = &records[pos & mask];
+				Size seq = r->sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+				if (diff == 0)
+				{
+					if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+				}
+				else if (diff < 0)
+				{
+					// Full, the main thread has not caught up
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				else
+				{
+					pos = pushPos.load(std::memory_order_relaxed);
+				}
+			}
+
+			r->source = source;
+			r->severity = severity;
+			r->id = id;
+			r->category = category;
+			r->length = std::min(length, maxMessageLength);
+			std::memcpy(r->text, text, r->length);
+			r->text[r->length] = '\0';
+
+			r->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Returns the next filled record, or nullptr if there are none.
+		// The record must be released with Release() before popping again.
+		Record* Peek()
+		{
+			Record* r = &records[popPos & mask];
+			if (r->sequence.load(std::memory_order_acquire) != popPos + 1) return nullptr;
+			return r;
+		}
+
+		void Release(Record* r)
+		{
+			r->sequence.store(popPos + mask + 1, std::memory_order_release);
+			popPos++;
+		}
+	};
+
+	// Repeats of a message since it was last reported, main thread only
+	struct MessageHistory
+	{
+		Double lastSent;
+		Size suppressed;
+		DiagnosticSource source;
+		DiagnosticSeverity severity;
+		std::int64_t id;
+		std::string text;
+	};
+
+	DiagnosticsArgs diagnosticsArgs;
+	std::unique_ptr<DiagnosticRing> ring;
+	std::unordered_map<std::uint64_t, MessageHistory> history;
+	Size suppressedMessages = 0;
+	Double lastSweep = 0.0;
+
+	// FNV-1a over the bytes of a value
+	void Mix(std::uint64_t& hash, std::uint64_t value)
+	{
+		for (Size i = 0; i < 8; i++)
+		{
+			hash = (hash ^ (value & 0xFF)) * 1099511628211ull;
+			value >>= 8;
+		}
+	}
+
+	std::uint64_t MessageKey(const Record& r)
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		Mix(hash, static_cast<std::uint64_t>(r.source));
+		Mix(hash, r.category);
+		Mix(hash, static_cast<std::uint64_t>(r.id));
+
+		// GLFW error codes are shared by many different errors, and most
+		// Vulkan loader and general messages have no ID at all
+		if (r.source == DiagnosticSource::GLFW || r.id == 0)
+		{
+			for (Size i = 0; i < r.length; i++)
+			{
+				hash = (hash ^ static_cast<unsigned char>(r.text[i])) * 1099511628211ull;
+			}
+		}
+
+		return hash;
+	}
+
+	void Send(FrameArena& arena, DiagnosticSource source, DiagnosticSeverity severity,
+		std::int64_t id, const char* text, Size length, Size count)
+	{
+		ArenaString message = arena.Copy(text, length);
+		SendEvent(DiagnosticEvent{source, severity, id, message, count});
+
+		// Listeners of ErrorEvent still hear about GLFW errors
+		if (source == DiagnosticSource::GLFW)
+		{
+			SendEvent(ErrorEvent{static_cast<Int>(id), message});
+		}
+	}
+
+	// OpenGL 4.3 / KHR_debug, loaded through GLFW like the sync functions
+	typedef void (VLFW_GLAPI* DebugProc)(unsigned int source, unsigned int type, unsigned int id,
+		unsigned int severity, int length, const char* message, const void* userParam);
+	typedef void (VLFW_GLAPI* DebugMessageCallbackProc)(DebugProc callback, const void* userParam);
+	typedef void (VLFW_GLAPI* EnableProc)(unsigned int cap);
+
+	constexpr unsigned int glDebugOutput =              0x92E0;
+	constexpr unsigned int glDebugSeverityHigh =        0x9146;
+	constexpr unsigned int glDebugSeverityMedium =      0x9147;
+	constexpr unsigned int glDebugSeverityLow =         0x9148;
+
+	void VLFW_GLAPI GLDebugCallback(unsigned int source, unsigned int type, unsigned int id,
+		unsigned int severity, int length, const char* message, const void*)
+	{
+		DiagnosticSeverity s = DiagnosticSeverity::Info;
+		if (severity == glDebugSeverityHigh) s = DiagnosticSeverity::Error;
+		else if (severity == glDebugSeverityMedium || severity == glDebugSeverityLow) s = DiagnosticSeverity::Warning;
+
+		Size len = length >= 0 ? static_cast<Size>(length) : std::strlen(message);
+		// IDs are only unique for a given source and type
+		ReportDiagnostic(DiagnosticSource::OpenGL, s, id, message, len, ((source & 0xFFFF) << 16) | (type & 0xFFFF));
+	}
+}
+
+void StartDiagnostics(const DiagnosticsArgs& args)
+{
+	diagnosticsArgs = args;
+	history.clear();
+	suppressedMessages = 0;
+	lastSweep = glfwGetTime();
+	ring.reset(new DiagnosticRing(args.capacity));
+}
+
+void StopDiagnostics()
+{
+	ring.reset();
+	history.clear();
+}
+
+bool IsCollectingDiagnostics()
+{
+	return ring != nullptr;
+}
+
+DiagnosticSeverity GetMinDiagnosticSeverity()
+{
+	return diagnosticsArgs.minSeverity;
+}
+
+bool WantsGLDebugOutput()
+{
+	return ring != nullptr && diagnosticsArgs.openglDebugOutput;
+}
+
+bool WantsVulkanDebugMessenger()
+{
+	return ring != nullptr && diagnosticsArgs.vulkanDebugMessenger;
+}
+
+void ReportDiagnostic(DiagnosticSource source, DiagnosticSeverity severity, std::int64_t id,
+	const char* message, Size length, std::uint32_t category)
+{
+	if (!ring || severity < diagnosticsArgs.minSeverity) return;
+	ring->Push(source, severity, id, category, message, length);
+}
+
+void InstallGLDebugOutput()
+{
+	DebugMessageCallbackProc debugMessageCallback =
+		reinterpret_cast<DebugMessageCallbackProc>(glfwGetProcAddress("glDebugMessageCallback"));
+	if (debugMessageCallback == nullptr)
+	{
+		debugMessageCallback = reinterpret_cast<DebugMessageCallbackProc>(glfwGetProcAddress("glDebugMessageCallbackKHR"));
+	}
+
+	EnableProc enable = reinterpret_cast<EnableProc>(glfwGetProcAddress("glEnable"));
+
+	// Context does not support debug output
+	if (debugMessageCallback == nullptr || enable == nullptr) return;
+
+	// Output is left asynchronous, the driver may call from any thread
+	debugMessageCallback(GLDebugCallback, nullptr);
+	enable(glDebugOutput);
+}
+
+Size GetDroppedDiagnostics()
+{
+	return ring ? ring->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+void SendDiagnostics(FrameArena& arena)
+{
+	if (!ring) return;
+
+	Double now = glfwGetTime();
+	Record* r;
+
+	while ((r = ring->Peek()) != nullptr)
+	{
+		auto found = history.find(MessageKey(*r));
+
+		if (found == history.end())
+		{
+			history.emplace(MessageKey(*r), MessageHistory{now, 0, r->source, r->severity, r->id, std::string()});
+			Send(arena, r->source, r->severity, r->id, r->text, r->length, 1);
+		}
+		else if (now - found->second.lastSent >= diagnosticsArgs.repeatInterval)
+		{
+			MessageHistory& h = found->second;
+			Send(arena, r->source, r->severity, r->id, r->text, r->length, h.suppressed + 1);
+
+			if (h.suppressed > 0) suppressedMessages--;
+			h.lastSent = now;
+			h.suppressed = 0;
+		}
+		else
+		{
+			// Keep the latest text so it can be reported once the interval
+			// has passed, assigning reuses the string's storage
+			MessageHistory& h = found->second;
+			if (h.suppressed == 0) suppressedMessages++;
+			h.suppressed++;
+			h.severity = r->severity;
+			h.text.assign(r->text, r->length);
+		}
+
+		ring->Release(r);
+	}
+
+	// Report repeats of messages that have since stopped arriving, and once
+	// per interval forget messages with nothing to report. A forgotten
+	// message is reported as new if it arrives again, which the interval
+	// allows anyway. GLFW keys include the message text, so without this
+	// the history would grow with every distinct error.
+	bool sweep = now - lastSweep >= diagnosticsArgs.repeatInterval;
+	if (suppressedMessages == 0 && !sweep) return;
+	if (sweep) lastSweep = now;
+
+	for (auto it = history.begin(); it != history.end();)
+	{
+		MessageHistory& h = it->second;
+
+		if (now - h.lastSent < diagnosticsArgs.repeatInterval)
+		{
+			it++;
+		}
+		else if (h.suppressed > 0)
+		{
+			Send(arena, h.source, h.severity, h.id, h.text.data(), h.text.size(), h.suppressed);
+
+			suppressedMessages--;
+			h.lastSent = now;
+			h.suppressed = 0;
+			it++;
+		}
+		else if (sweep)
+		{
+			it = history.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#include "VLFW/FrameArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+using namespace vlk;
+using namespace vlfw;
+
+FrameArena::FrameArena(Size initialSize) :
+	offset(0),
+	used(0)
+{
+	initialSize = std::max<Size>(initialSize, 64);
+	blocks.push_back(Block{std::unique_ptr<char[]>(new char[initialSize]), initialSize});
+}
+
+void* FrameArena::Allocate(Size size, Size alignment)
+{
+	Block& block = blocks.back();
+	std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.data.get());
+	std::uintptr_t start = (base + offset + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+
+	if (start + size <= base + block.size)
+	{
+		offset = static_cast<Size>(start - base) + size;
+		used += size;
+		return reinterpret_cast<void*>(start);
+	}
+
+	// Grow geometrically so a frame needs few blocks, blocks from new[] are
+	// aligned for any fundamental type
+	Size blockSize = std::max(block.size * 2, size + alignment);
+	blocks.push_back(Block{std::unique_ptr<char[]>(new char[blockSize]), blockSize});
+	offset = 0;
+
+	return Allocate(size, alignment);
+}
+
+ArenaString FrameArena::Copy(const char* str, Size length)
+{
+	char* data = Allocate<char>(length + 1);
+	std::memcpy(data, str, length);
+	data[length] = '\0';
+
+	return ArenaString{data, length};
+}
+
+ArenaString FrameArena::Copy(const char* str)
+{
+	return Copy(str, std::strlen(str));
+}
+
+void FrameArena::Swap(FrameArena& other)
+{
+	blocks.swap(other.blocks);
+	std::swap(offset, other.offset);
+	std::swap(used, other.used);
+}
+
+void FrameArena::Reset()
+{
+	// Replace the blocks with one that fits everything this frame needed
+	if (blocks.size() > 1)
+	{
+		Size capacity = GetCapacity();
+		blocks.clear();
+		blocks.push_back(Block{std::unique_ptr<char[]>(new char[capacity]), capacity});
+	}
+
+	offset = 0;
+	used = 0;
+}
+
+Size FrameArena::GetCapacity() const
+{
+	Size capacity = 0;
+	for (auto it = blocks.cbegin(); it != blocks.cend(); it++) capacity += it->size;
+
+	return capacity;
+}
@@ -0,0 +1,165 @@
+#include "VLFW/FramePacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+using namespace vlk;
+using namespace vlfw;
+
+namespace
+{
+	// Used if a monitor does not report its refresh rate
+	constexpr Int fallbackRefreshRate = 60;
+
+	Double Seconds(FramePacer::Clock::duration d)
+	{
+		return std::chrono::duration<Double>(d).count();
+	}
+
+	FramePacer::Clock::duration Duration(Double seconds)
+	{
+		return std::chrono::duration_cast<FramePacer::Clock::duration>(
+			std::chrono::duration<Double>(seconds));
+	}
+
+	// Finds the monitor containing the center of a windowed window
+	const Monitor* FindMonitor(const Window* window)
+	{
+		Point<Int> pos = window->GetPosition();
+		Point<Int> size = window->GetSize();
+		Int x = pos.X() + size.X() / 2;
+		Int y = pos.Y() + size.Y() / 2;
+
+		const std::vector<Monitor*>& monitors = Monitor::GetMonitors();
+		for (auto it = monitors.cbegin(); it != monitors.cend(); it++)
+		{
+			Point<Int> mpos = (*it)->GetPosition();
+			VideoMode mode = (*it)->GetVideoMode();
+
+			if (x >= mpos.X() && x < mpos.X() + mode.size.X() &&
+			    y >= mpos.Y() && y < mpos.Y() + mode.size.Y())
+			{
+				return *it;
+			}
+		}
+
+		return nullptr;
+	}
+}
+
+FramePacer::FramePacer(const FramePacerArgs& args) :
+	window(args.window),
+	frameRateCap(args.frameRateCap),
+	safetyMargin(args.safetyMargin),
+	spinThreshold(args.spinThreshold),
+	period(1.0 / fallbackRefreshRate),
+	periodDirty(true),
+	costs(args.costSamples, 0.0),
+	nextCost(0),
+	frameStart(Clock::now()),
+	lastPresent(),
+	presented(false)
+{
+	if (args.costSamples == 0)
+	{
+		throw std::runtime_error("FramePacer must consider at least one frame cost sample.");
+	}
+}
+
+void FramePacer::OnEvent(const Window::MoveEvent& ev)
+{
+	if (ev.window == window) periodDirty = true;
+}
+
+void FramePacer::OnEvent(const Monitor::ConnectEvent&)
+{
+	periodDirty = true;
+}
+
+void FramePacer::OnEvent(const Monitor::DisconnectEvent&)
+{
+	periodDirty = true;
+}
+
+void FramePacer::UpdatePeriod()
+{
+	const Monitor* monitor = nullptr;
+
+	if (window != nullptr)
+	{
+		monitor = window->GetMonitor();
+		if (monitor == nullptr) monitor = FindMonitor(window);
+	}
+
+	if (monitor == nullptr) monitor = Monitor::GetPrimaryMonitor();
+
+	Int refreshRate = 0;
+	if (monitor != nullptr) refreshRate = monitor->GetVideoMode().refreshRate;
+	if (refreshRate <= 0) refreshRate = fallbackRefreshRate;
+
+	period = 1.0 / refreshRate;
+	if (frameRateCap > 0.0) period = std::max(period, 1.0 / frameRateCap);
+
+	periodDirty = false;
+}
+
+void FramePacer::WaitForFrameStart()
+{
+	if (periodDirty) UpdatePeriod();
+
+	if (presented)
+	{
+		// Aim for the first refresh after the last present that this frame
+		// can still finish before
+		Double cost = GetEstimatedFrameCost() + safetyMargin;
+		Double elapsed = Seconds(Clock::now() - lastPresent);
+		Double refreshes = std::max(1.0, std::ceil((elapsed + cost) / period));
+
+		Clock::time_point start = lastPresent + Duration(refreshes * period - cost);
+		Clock::time_point spinFrom = start - Duration(spinThreshold);
+
+		if (Clock::now() < spinFrom) std::this_thread::sleep_until(spinFrom);
+		while (Clock::now() < start) std::this_thread::yield();
+	}
+
+	frameStart = Clock::now();
+}
+
+void FramePacer::MarkWorkDone()
+{
+	costs[nextCost] = Seconds(Clock::now() - frameStart);
+	nextCost = (nextCost + 1) % costs.size();
+}
+
+void FramePacer::MarkPresented()
+{
+	lastPresent = Clock::now();
+	presented = true;
+}
+
+Double FramePacer::GetFramePeriod()
+{
+	if (periodDirty) UpdatePeriod();
+	return period;
+}
+
+Double FramePacer::GetEstimatedFrameCost() const
+{
+	return *std::max_element(costs.cbegin(), costs.cend());
+}
+
+void FramePacer::SetWindow(Window* w)
+{
+	if (w == window) return;
+
+	window = w;
+	periodDirty = true;
+}
+
+void FramePacer::SetFrameRateCap(Double cap)
+{
+	frameRateCap = cap;
+	periodDirty = true;
+}
@@ -0,0 +1,141 @@
+#include "VLFW/InputSampler.hpp"
+
+#include <stdexcept>
+
+using namespace vlk;
+using namespace vlfw;
+
+InputSampler::InputSampler(const InputSamplerArgs& args) :
+	history(args.historyLength),
+	epoch(Clock::now()),
+	tickDuration(args.tickDuration)
+{
+	if (!(tickDuration > 0.0))
+	{
+		throw std::runtime_error("InputSampler tick duration must be positive.");
+	}
+}
+
+std::uint64_t InputSampler::GetTick(Clock::time_point time) const
+{
+	if (time <= epoch) return 0;
+
+	Double elapsed = std::chrono::duration<Double>(time - epoch).count();
+	return static_cast<std::uint64_t>(elapsed / tickDuration);
+}
+
+// Closes every tick before the given one, carrying held keys and buttons
+// over into each of them.
+void InputSampler::Advance(std::uint64_t tick)
+{
+	if (tick <= current.tick) return;
+
+	history.Push(current);
+	current.ClearEdges();
+
+	// Ticks that would be overwritten immediately are not worth writing
+	std::uint64_t first = current.tick + 1;
+	if (tick - first > history.GetCapacity())
+	{
+		first = tick - history.GetCapacity();
+	}
+
+	for (std::uint64_t t = first; t < tick; t++)
+	{
+		current.tick = t;
+		history.Push(current);
+	}
+
+	current.tick = tick;
+}
+
+void InputSampler::Sample()
+{
+	Advance(GetCurrentTick());
+}
+
+void InputSampler::OnEvent(const Window::KeyDownEvent& ev)
+{
+	Sample();
+	current.PressKey(ev.key);
+}
+
+void InputSampler::OnEvent(const Window::KeyUpEvent& ev)
+{
+	Sample();
+	current.ReleaseKey(ev.key);
+}
+
+void InputSampler::OnEvent(const Window::MouseButtonDownEvent& ev)
+{
+	Sample();
+	current.PressButton(ev.button);
+}
+
+void InputSampler::OnEvent(const Window::MouseButtonUpEvent& ev)
+{
+	Sample();
+	current.ReleaseButton(ev.button);
+}
+
+void InputSampler::OnEvent(const Window::MouseMoveEvent& ev)
+{
+	Sample();
+	current.mousePos = ev.position;
+}
+
+void InputSampler::OnEvent(const Window::ScrollEvent& ev)
+{
+	Sample();
+	current.scrollDelta += ev.scrollAmount;
+}
+
+const InputSnapshot* InputSampler::GetSnapshot(std::uint64_t tick)
+{
+	Sample();
+
+	if (tick == current.tick)
+	{
+		return &current;
+	}
+	else
+	{
+		return history.Find(tick);
+	}
+}
+
+bool InputSampler::IsKeyDown(Key key, std::uint64_t tick)
+{
+	const InputSnapshot* s = GetSnapshot(tick);
+	return s && s->IsKeyDown(key);
+}
+
+bool InputSampler::IsKeyPressed(Key key, std::uint64_t tick)
+{
+	const InputSnapshot* s = GetSnapshot(tick);
+	return s && s->IsKeyPressed(key);
+}
+
+bool InputSampler::IsKeyReleased(Key key, std::uint64_t tick)
+{
+	const InputSnapshot* s = GetSnapshot(tick);
+	return s && s->IsKeyReleased(key);
+}
+
+bool InputSampler::IsButtonDown(MouseButton button, std::uint64_t tick)
+{
+	const InputSnapshot* s = GetSnapshot(tick);
+	return s && s->IsButtonDown(button);
+}
+
+bool InputSampler::IsButtonPressed(MouseButton button, std::uint64_t tick)
+{
+	const InputSnapshot* s = GetSnapshot(tick);
+	return s && s->IsButtonPressed(button);
+}
+
+bool InputSampler::IsButtonReleased(MouseButton button, std::uint64_t tick)
+{
+	const InputSnapshot* s = GetSnapshot(tick);
+	return s && s->IsButtonReleased(button);
+}
@@ -0,0 +1,335 @@
+#include "VLFW/InputSnapshot.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace vlk;
+using namespace vlfw;
+
+namespace
+{
+	// Bit layout of the field mask written by EncodeDelta
+	constexpr Size keyMaskBits = InputSnapshot::KeyWordCount * 3;
+	constexpr std::uint32_t buttonsBit = 1u << (keyMaskBits + 0);
+	constexpr std::uint32_t mousePosBit = 1u << (keyMaskBits + 1);
+	constexpr std::uint32_t scrollBit = 1u << (keyMaskBits + 2);
+
+	static_assert(keyMaskBits + 3 <= 32, "InputSnapshot field mask must fit in 32 bits");
+
+	inline bool KeyIndex(Key key, Int& word, std::uint64_t& bit)
+	{
+		Int k = static_cast<Int>(key);
+		if (k < 0 || k > static_cast<Int>(Key::Last)) return false;
+		word = k >> 6;
+		bit = std::uint64_t(1) << (k & 63);
+		return true;
+	}
+
+	inline bool ButtonBit(MouseButton button, std::uint8_t& bit)
+	{
+		Int b = static_cast<Int>(button);
+		if (b < 0 || b >= static_cast<Int>(InputSnapshot::MouseButtonCount)) return false;
+		bit = static_cast<std::uint8_t>(1u << b);
+		return true;
+	}
+
+	inline const std::uint64_t* KeyWords(const InputSnapshot& s, Size array)
+	{
+		switch (array)
+		{
+			case 0: return s.keysDown;
+			case 1: return s.keysPressed;
+			default: return s.keysReleased;
+		}
+	}
+
+	inline std::uint64_t* KeyWords(InputSnapshot& s, Size array)
+	{
+		return const_cast<std::uint64_t*>(KeyWords(static_cast<const InputSnapshot&>(s), array));
+	}
+
+	inline Size WriteVarint(std::uint64_t value, unsigned char* out)
+	{
+		Size n = 0;
+		while (value >= 0x80)
+		{
+			out[n++] = static_cast<unsigned char>(value | 0x80);
+			value >>= 7;
+		}
+		out[n++] = static_cast<unsigned char>(value);
+		return n;
+	}
+
+	inline Size ReadVarint(const unsigned char* data, Size size, std::uint64_t& value)
+	{
+		value = 0;
+		for (Size n = 0; n < size && n < 10; n++)
+		{
+			value |= std::uint64_t(data[n] & 0x7F) << (7 * n);
+			if (!(data[n] & 0x80)) return n + 1;
+		}
+		return 0;
+	}
+
+	inline void WriteU64(std::uint64_t value, unsigned char* out)
+	{
+		for (Size i = 0; i < 8; i++) out[i] = static_cast<unsigned char>(value >> (8 * i));
+	}
+
+	inline std::uint64_t ReadU64(const unsigned char* data)
+	{
+		std::uint64_t value = 0;
+		for (Size i = 0; i < 8; i++) value |= std::uint64_t(data[i]) << (8 * i);
+		return value;
+	}
+
+	// Writes a pair of floats as little-endian bit patterns
+	inline void WriteVector(const Vector2& v, unsigned char* out)
+	{
+		std::uint32_t x, y;
+		std::memcpy(&x, &v.X(), 4);
+		std::memcpy(&y, &v.Y(), 4);
+		WriteU64(std::uint64_t(x) | (std::uint64_t(y) << 32), out);
+	}
+
+	inline Vector2 ReadVector(const unsigned char* data)
+	{
+		std::uint64_t bits = ReadU64(data);
+		std::uint32_t x = static_cast<std::uint32_t>(bits), y = static_cast<std::uint32_t>(bits >> 32);
+		Vector2 v;
+		std::memcpy(&v.X(), &x, 4);
+		std::memcpy(&v.Y(), &y, 4);
+		return v;
+	}
+
+	inline bool SameVector(const Vector2& a, const Vector2& b)
+	{
+		// Compare bit patterns so the encoder is lossless for every value
+		return std::memcmp(&a.X(), &b.X(), 4) == 0 && std::memcmp(&a.Y(), &b.Y(), 4) == 0;
+	}
+}
+
+void InputSnapshot::PressKey(Key key)
+{
+	Int w; std::uint64_t b;
+	if (!KeyIndex(key, w, b)) return;
+	keysDown[w] |= b;
+	keysPressed[w] |= b;
+}
+
+void InputSnapshot::ReleaseKey(Key key)
+{
+	Int w; std::uint64_t b;
+	if (!KeyIndex(key, w, b)) return;
+	keysDown[w] &= ~b;
+	keysReleased[w] |= b;
+}
+
+void InputSnapshot::PressButton(MouseButton button)
+{
+	std::uint8_t b;
+	if (!ButtonBit(button, b)) return;
+	buttonsDown |= b;
+	buttonsPressed |= b;
+}
+
+void InputSnapshot::ReleaseButton(MouseButton button)
+{
+	std::uint8_t b;
+	if (!ButtonBit(button, b)) return;
+	buttonsDown &= ~b;
+	buttonsReleased |= b;
+}
+
+void InputSnapshot::ClearEdges()
+{
+	for (Size i = 0; i < KeyWordCount; i++)
+	{
+		keysPressed[i] = 0;
+		keysReleased[i] = 0;
+	}
+
+	buttonsPressed = 0;
+	buttonsReleased = 0;
+	scrollDelta = Vector2();
+}
+
+bool InputSnapshot::operator==(const InputSnapshot& other) const
+{
+	return tick == other.tick &&
+	       std::memcmp(keysDown, other.keysDown, sizeof(keysDown)) == 0 &&
+	       std::memcmp(keysPressed, other.keysPressed, sizeof(keysPressed)) == 0 &&
+	       std::memcmp(keysReleased, other.keysReleased, sizeof(keysReleased)) == 0 &&
+	       buttonsDown == other.buttonsDown &&
+	       buttonsPressed == other.buttonsPressed &&
+	       buttonsReleased == other.buttonsReleased &&
+	       SameVector(mousePos, other.mousePos) &&
+	       SameVector(scrollDelta, other.scrollDelta);
+}
+
+// Layout: varint tick delta, varint field mask, then every field whose bit
+// is set in the mask, in mask order. Key words are XORed against the base
+// so the receiver can apply them without knowing which bits were set.
+Size InputSnapshot::EncodeDelta(const InputSnapshot& base, const InputSnapshot& current, unsigned char* out)
+{
+	std::uint32_t mask = 0;
+
+	for (Size a = 0; a < 3; a++)
+	{
+		const std::uint64_t* b = KeyWords(base, a);
+		const std::uint64_t* c = KeyWords(current, a);
+
+		for (Size i = 0; i < KeyWordCount; i++)
+		{
+			if (b[i] != c[i]) mask |= 1u << (a * KeyWordCount + i);
+		}
+	}
+
+	if (base.buttonsDown != current.buttonsDown ||
+	    base.buttonsPressed != current.buttonsPressed ||
+	    base.buttonsReleased != current.buttonsReleased)
+	{
+		mask |= buttonsBit;
+	}
+
+	if (!SameVector(base.mousePos, current.mousePos)) mask |= mousePosBit;
+	if (!SameVector(base.scrollDelta, current.scrollDelta)) mask |= scrollBit;
+
+	Size n = 0;
+	n += WriteVarint(current.tick - base.tick, out + n);
+	n += WriteVarint(mask, out + n);
+
+	for (Size a = 0; a < 3; a++)
+	{
+		const std::uint64_t* b = KeyWords(base, a);
+		const std::uint64_t* c = KeyWords(current, a);
+
+		for (Size i = 0; i < KeyWordCount; i++)
+		{
+			if (mask & (1u << (a * KeyWordCount + i)))
+			{
+				WriteU64(b[i] ^ c[i], out + n);
+				n += 8;
+			}
+		}
+	}
+
+	if (mask & buttonsBit)
+	{
+		out[n++] = current.buttonsDown;
+		out[n++] = current.buttonsPressed;
+		out[n++] = current.buttonsReleased;
+	}
+
+	if (mask & mousePosBit)
+	{
+		WriteVector(current.mousePos, out + n);
+		n += 8;
+	}
+
+	if (mask & scrollBit)
+	{
+		WriteVector(current.scrollDelta, out + n);
+		n += 8;
+	}
+
+	return n;
+}
+
+Size InputSnapshot::DecodeDelta(const InputSnapshot& base, const unsigned char* data, Size size, InputSnapshot& out)
+{
+	out = base;
+
+	std::uint64_t tickDelta, mask;
+	Size n = 0, r;
+
+	if ((r = ReadVarint(data + n, size - n, tickDelta)) == 0) return 0;
+	n += r;
+	if ((r = ReadVarint(data + n, size - n, mask)) == 0) return 0;
+	n += r;
+
+	if (mask >> (keyMaskBits + 3)) return 0;
+
+	out.tick = base.tick + tickDelta;
+
+	for (Size a = 0; a < 3; a++)
+	{
+		std::uint64_t* o = KeyWords(out, a);
+
+		for (Size i = 0; i < KeyWordCount; i++)
+		{
+			if (mask & (1u << (a * KeyWordCount + i)))
+			{
+				if (size - n < 8) return 0;
+				o[i] ^= ReadU64(data + n);
+				n += 8;
+			}
+		}
+	}
+
+	if (mask & buttonsBit)
+	{
+		if (size - n < 3) return 0;
+		out.buttonsDown = data[n++];
+		out.buttonsPressed = data[n++];
+		out.buttonsReleased = data[n++];
+	}
+
+	if (mask & mousePosBit)
+	{
+		if (size - n < 8) return 0;
+		out.mousePos = ReadVector(data + n);
+		n += 8;
+	}
+
+	if (mask & scrollBit)
+	{
+		if (size - n < 8) return 0;
+		out.scrollDelta = ReadVector(data + n);
+		n += 8;
+	}
+
+	return n;
+}
+
+/////////////////////
+//// InputHistory ///
+/////////////////////
+
+InputHistory::InputHistory(Size capacity) :
+	ring(capacity),
+	occupied(capacity, false),
+	latest(0)
+{
+	if (capacity == 0)
+	{
+		throw std::runtime_error("InputHistory capacity must be non-zero.");
+	}
+}
+
+void InputHistory::Push(const InputSnapshot& snapshot)
+{
+	latest = snapshot.tick % ring.size();
+	ring[latest] = snapshot;
+	occupied[latest] = true;
+}
+
+const InputSnapshot* InputHistory::Find(std::uint64_t tick) const
+{
+	Size i = tick % ring.size();
+
+	if (occupied[i] && ring[i].tick == tick)
+	{
+		return &ring[i];
+	}
+	else
+	{
+		return nullptr;
+	}
+}
+
+void InputHistory::Clear()
+{
+	occupied.assign(occupied.size(), false);
+	latest = 0;
+}
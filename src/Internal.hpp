@@ -0,0 +1,194 @@
+#ifndef VLFW_INTERNAL_HPP
+#define VLFW_INTERNAL_HPP
+
+// Declarations shared between VLFW's translation units. Not installed.
+
+#include "VLFW/VLFW.hpp"
+#include "GLFW/glfw3.h"
+
+#include <cstdint>
+#include <functional>
+
+namespace vlk
+{
+	namespace vlfw
+	{
+		// Gives callbacks access to a window's internals
+		struct WindowAccess
+		{
+			static inline Window::CachedState& Cache(Window* w) { return w->cache; }
+			static inline Window::PendingWrites& Pending(Window* w) { return w->pending; }
+			static inline Size& TableIndex(Window* w) { return w->tableIndex; }
+			static inline Size TableIndex(const Window* w) { return w->tableIndex; }
+
+			template<typename T>
+			static inline void Deliver(Window* w, const T& ev) { w->Deliver(ev); }
+		};
+	}
+}
+
+// GLFW callbacks installed by the Window constructor. Anything that wants
+// its input to be indistinguishable from real input should go through these.
+void CloseCallback(GLFWwindow* window);
+void ResizeCallback(GLFWwindow* window, vlk::Int x, vlk::Int y);
+void FramebufferResizeCallback(GLFWwindow* window, vlk::Int x, vlk::Int y);
+void ContentScaleCallback(GLFWwindow* window, vlk::Float x, vlk::Float y);
+void MoveCallback(GLFWwindow* window, vlk::Int x, vlk::Int y);
+void MinimizeCallback(GLFWwindow* window, vlk::Int action);
+void MaximizeCallback(GLFWwindow* window, vlk::Int action);
+void FocusCallback(GLFWwindow* window, vlk::Int action);
+void RefreshCallback(GLFWwindow* window);
+void KeyCallback(GLFWwindow* window, vlk::Int key, vlk::Int scancode, vlk::Int action, vlk::Int mods);
+void CharCallback(GLFWwindow* window, vlk::UInt codepoint);
+void CursorEnterCallback(GLFWwindow* window, vlk::Int entered);
+void CursorPosCallback(GLFWwindow* window, double xpos, double ypos);
+void MouseButtonCallback(GLFWwindow* window, vlk::Int button, vlk::Int action, vlk::Int mods);
+void ScrollCallback(GLFWwindow* window, double x, double y);
+void FileDropCallback(GLFWwindow* window, vlk::Int count, const char** paths);
+
+// Events from callbacks are either sent immediately or, when using
+// VLFWMainArgs::eventBudget, buffered and sent by VLFWMain within the budget.
+// Low priority events may be deferred to a later frame.
+enum class EventPriority
+{
+	High,
+	Low
+};
+
+bool IsBufferingEvents();
+void BufferEvent(EventPriority priority, vlk::vlfw::Window* window, std::function<void()> send);
+
+// Buffered cursor moves of a window are merged into a single low priority
+// MouseMoveEvent with the latest position. Promoting sends that position
+// with the high priority events, before a mouse button event buffered next.
+void BufferCursorMove(vlk::vlfw::Window* window, const vlk::Vector2& position);
+void PromoteCursorMove(vlk::vlfw::Window* window);
+
+// Identifies a registered window, or 0 if the window is not registered.
+// IsWindowLive() does not touch the window, so it may be called after the
+// window has been destroyed. It searches every window, so callers only use it
+// after the count of removed windows has changed.
+std::uint64_t GetWindowGeneration(const vlk::vlfw::Window* window);
+std::uint64_t GetWindowUnregistrations();
+bool IsWindowLive(const vlk::vlfw::Window* window, std::uint64_t generation);
+
+// Sends an event to listeners, then to handlers subscribed to its window.
+// Listeners may destroy the window, its handlers are then skipped.
+template<typename T>
+void RouteEvent(const T& ev)
+{
+	if (ev.window == nullptr)
+	{
+		vlk::SendEvent(ev);
+		return;
+	}
+
+	std::uint64_t generation = GetWindowGeneration(ev.window);
+	std::uint64_t removed = GetWindowUnregistrations();
+	vlk::SendEvent(ev);
+
+	if (generation == 0) return;
+
+	if (GetWindowUnregistrations() == removed || IsWindowLive(ev.window, generation))
+	{
+		vlk::vlfw::WindowAccess::Deliver(ev.window, ev);
+	}
+}
+
+template<typename T>
+void DispatchEvent(EventPriority priority, const T& ev)
+{
+	if (IsBufferingEvents())
+	{
+		BufferEvent(priority, ev.window, [ev]() { RouteEvent(ev); });
+	}
+	else
+	{
+		RouteEvent(ev);
+	}
+}
+
+// Maps dropped files in the background when using
+// VLFWMainArgs::mapDroppedFiles, then sends a FileDropReadyEvent
+void MapDroppedFiles(vlk::vlfw::Window* window, const vlk::vlfw::ArenaString* paths, vlk::Size count);
+
+// Arena that event payloads are allocated from, or nullptr if there is no
+// VLFWMain. Must only be used on the main thread.
+vlk::vlfw::FrameArena* GetEventArena();
+
+// Records a typed character to be sent in a TextInputEvent, returns false if
+// not using VLFWMainArgs::batchTextInput
+bool BufferTextInput(vlk::vlfw::Window* window, char32_t codepoint);
+
+enum class InjectedType
+{
+	Key,
+	Char,
+	MouseButton,
+	MouseMove,
+	Scroll,
+	CursorEnter
+};
+
+// Synthetic input waiting to be delivered. Arguments are stored the way
+// the matching GLFW callback expects them.
+struct InjectedInput
+{
+	InjectedType type;
+	GLFWwindow* window;
+	vlk::Int a, b, c;
+	double x, y;
+};
+
+// Queues input to be delivered through the GLFW callbacks during the next
+// PreUpdateEvent, see VLFWMain::InjectKeyDown(). May be called from any
+// thread.
+void InjectInput(const InjectedInput& input);
+
+// Drops any input injected through VLFWMain that has not been delivered to
+// this window yet. Called when the window is destroyed.
+void DiscardInjectedInput(GLFWwindow* window);
+
+// Maintain VLFWMain's table of live windows. Windows register themselves
+// once fully constructed and unregister when destroyed.
+void RegisterWindow(vlk::vlfw::Window* window);
+void UnregisterWindow(vlk::vlfw::Window* window);
+void SetWindowCloseRequested(vlk::vlfw::Window* window, bool requested);
+void SetWindowMinimized(vlk::vlfw::Window* window, bool minimized);
+
+// Flag a window as needing to be redrawn, see VLFWMainArgs::redrawOnDemand
+void MarkWindowDirty(GLFWwindow* window);
+bool WindowNeedsRedraw(const vlk::vlfw::Window* window);
+
+// Diagnostics pipeline, see VLFWMainArgs::diagnostics. ReportDiagnostic may
+// be called from any thread, it copies the message into a lock-free ring
+// which SendDiagnostics drains on the main thread at the end of a frame.
+// The category tells apart messages that share an ID, such as OpenGL messages
+// from different sources, it is only used to detect repeats.
+void StartDiagnostics(const vlk::vlfw::DiagnosticsArgs& args);
+void StopDiagnostics();
+bool IsCollectingDiagnostics();
+vlk::vlfw::DiagnosticSeverity GetMinDiagnosticSeverity();
+bool WantsGLDebugOutput();
+bool WantsVulkanDebugMessenger();
+void ReportDiagnostic(vlk::vlfw::DiagnosticSource source, vlk::vlfw::DiagnosticSeverity severity,
+	std::int64_t id, const char* message, vlk::Size length, std::uint32_t category = 0);
+void SendDiagnostics(vlk::vlfw::FrameArena& arena);
+vlk::Size GetDroppedDiagnostics();
+
+// Installs the diagnostics callback on the current OpenGL context, if it
+// supports debug output
+void InstallGLDebugOutput();
+
+// Called when a write is held back by WindowHints::titleUpdateInterval, so
+// a main thread waiting for events wakes at the given time to apply it
+void WakeForDeferredWrite(vlk::Double time);
+
+// Called by callbacks that count as activity for WaitMode::Adaptive
+void NotifyActivity();
+
+// Called after a command has been posted to any window, wakes the main
+// thread if it is waiting for events
+void NotifyWindowCommandPosted();
+
+#endif
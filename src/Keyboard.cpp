@@ -1,6 +1,7 @@
 #include "VLFW/Keyboard.hpp"
 
 #include "GLFW/glfw3.h"
+#include <cstring>
 #include <stdexcept>
 #include <unordered_set>
 
@@ -18,6 +19,9 @@ namespace
 	// Keys that are currently down
 	std::unordered_set<Int> downSet;
 
+	// Key token state, kept packed for snapshots
+	InputSnapshot keyState;
+
 	// KeyboardMain access
 	std::mutex mtx;
 }
@@ -240,6 +244,7 @@ KeyboardMain::KeyboardMain(const KeyboardMainArgs&) :
 	pressedSet.clear();
 	releasedSet.clear();
 	downSet.clear();
+	keyState = InputSnapshot();
 }
 
 // Keys should be pressed for at least one frame
@@ -252,16 +257,26 @@ void KeyboardMain::OnEvent(const Window::KeyDownEvent& ev)
 {
 	pressedSet.insert(ev.scancode);
 	downSet.insert(ev.scancode);
+	keyState.PressKey(ev.key);
 }
 
 void KeyboardMain::OnEvent(const Window::KeyUpEvent& ev)
 {
 	releasedSet.insert(ev.scancode);
 	downSet.erase(ev.scancode);
+	keyState.ReleaseKey(ev.key);
 }
 
 void KeyboardMain::OnEvent(const PostUpdateEvent&)
 {
 	pressedSet.clear();
 	releasedSet.clear();
+	keyState.ClearEdges();
+}
+
+void KeyboardMain::WriteSnapshot(InputSnapshot& snapshot)
+{
+	std::memcpy(snapshot.keysDown, keyState.keysDown, sizeof(snapshot.keysDown));
+	std::memcpy(snapshot.keysPressed, keyState.keysPressed, sizeof(snapshot.keysPressed));
+	std::memcpy(snapshot.keysReleased, keyState.keysReleased, sizeof(snapshot.keysReleased));
 }
@@ -0,0 +1,167 @@
+#include "VLFW/MappedFile.hpp"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define VLFW_HAS_WIN32_MMAP
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define VLFW_HAS_POSIX_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace vlk;
+using namespace vlfw;
+
+#ifdef VLFW_HAS_WIN32_MMAP
+namespace
+{
+	std::wstring Widen(const std::string& str)
+	{
+		int length = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, nullptr, 0);
+		if (length <= 0) return std::wstring();
+
+		std::wstring wide(static_cast<Size>(length), L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &wide[0], length);
+		wide.resize(static_cast<Size>(length) - 1);
+
+		return wide;
+	}
+}
+#endif
+
+MappedFile::MappedFile(const std::string& p) :
+	data(nullptr),
+	size(0),
+	path(p)
+{
+#if defined(VLFW_HAS_POSIX_MMAP)
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+	{
+		close(fd);
+		throw std::runtime_error("Not a regular file: " + path);
+	}
+
+	size = static_cast<Size>(info.st_size);
+
+	if (size > 0)
+	{
+		void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view == MAP_FAILED)
+		{
+			close(fd);
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+
+		data = view;
+	}
+
+	// The mapping keeps the file open
+	close(fd);
+#elif defined(VLFW_HAS_WIN32_MMAP)
+	HANDLE file = CreateFileW(Widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		throw std::runtime_error("Failed to get the size of file: " + path);
+	}
+
+	size = static_cast<Size>(fileSize.QuadPart);
+
+	if (size > 0)
+	{
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+		// The view keeps the mapping and file open
+		if (mapping) CloseHandle(mapping);
+
+		if (view == nullptr)
+		{
+			CloseHandle(file);
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+
+		data = view;
+	}
+
+	CloseHandle(file);
+#else
+	throw std::runtime_error("Memory mapped files are not supported on this platform.");
+#endif
+}
+
+void MappedFile::Prefetch() const
+{
+	if (data == nullptr) return;
+
+	Size pageSize = 4096;
+
+#if defined(VLFW_HAS_POSIX_MMAP)
+	long systemPageSize = sysconf(_SC_PAGESIZE);
+	if (systemPageSize > 0) pageSize = static_cast<Size>(systemPageSize);
+
+	// Start reading ahead for the whole file at once
+	madvise(const_cast<void*>(data), size, MADV_WILLNEED);
+#elif defined(VLFW_HAS_WIN32_MMAP)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	pageSize = static_cast<Size>(info.dwPageSize);
+
+	// Windows 8 and later, looked up so older versions can still load VLFW
+	typedef BOOL (WINAPI* PrefetchProc)(HANDLE, ULONG_PTR, PWIN32_MEMORY_RANGE_ENTRY, ULONG);
+	PrefetchProc prefetch = reinterpret_cast<PrefetchProc>(
+		GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory"));
+
+	if (prefetch != nullptr)
+	{
+		WIN32_MEMORY_RANGE_ENTRY range;
+		range.VirtualAddress = const_cast<void*>(data);
+		range.NumberOfBytes = size;
+		prefetch(GetCurrentProcess(), 1, &range, 0);
+	}
+#endif
+
+	// Touch every page so the page faults are taken on the calling thread,
+	// not by whoever reads the file later
+	const volatile unsigned char* bytes = static_cast<const volatile unsigned char*>(data);
+	unsigned char sink = 0;
+
+	for (Size i = 0; i < size; i += pageSize)
+	{
+		sink ^= bytes[i];
+	}
+
+	static_cast<void>(sink);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data == nullptr) return;
+
+#if defined(VLFW_HAS_POSIX_MMAP)
+	munmap(const_cast<void*>(data), size);
+#elif defined(VLFW_HAS_WIN32_MMAP)
+	UnmapViewOfFile(data);
+#endif
+}
@@ -25,6 +25,9 @@ namespace
 	// Scroll performed this frame
 	Vector2 scrollDelta;
 
+	// Button state, kept packed for snapshots
+	InputSnapshot buttonState;
+
 	std::mutex mtx;
 }
 
@@ -48,6 +51,7 @@ MouseMain::MouseMain(const MouseMainArgs&) :
 	mousePos = Vector2();
 	lastMouse = Vector2();
 	scrollDelta = Vector2();
+	buttonState = InputSnapshot();
 }
 
 bool Mouse::IsButtonDown(MouseButton button)
@@ -89,12 +93,14 @@ void MouseMain::OnEvent(const Window::MouseButtonDownEvent& ev)
 {
 	pressedSet.insert(ev.button);
 	downSet.insert(ev.button);
+	buttonState.PressButton(ev.button);
 }
 
 void MouseMain::OnEvent(const Window::MouseButtonUpEvent& ev)
 {
 	releasedSet.insert(ev.button);
 	downSet.erase(ev.button);
+	buttonState.ReleaseButton(ev.button);
 }
 
 void MouseMain::OnEvent(const Window::MouseMoveEvent& ev)
@@ -113,4 +119,14 @@ void MouseMain::OnEvent(const PostUpdateEvent&)
 	releasedSet.clear();
 	lastMouse = mousePos;
 	scrollDelta = Vector2();
+	buttonState.ClearEdges();
+}
+
+void MouseMain::WriteSnapshot(InputSnapshot& snapshot)
+{
+	snapshot.buttonsDown = buttonState.buttonsDown;
+	snapshot.buttonsPressed = buttonState.buttonsPressed;
+	snapshot.buttonsReleased = buttonState.buttonsReleased;
+	snapshot.mousePos = mousePos;
+	snapshot.scrollDelta = scrollDelta;
 }
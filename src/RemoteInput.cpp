@@ -0,0 +1,410 @@
+#include "VLFW/RemoteInput.hpp"
+#include "Internal.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VLFW_HAS_POSIX_SOCKETS
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace vlk;
+using namespace vlfw;
+
+namespace
+{
+	constexpr std::uint32_t packetMagic = 0x49524C56; // "VLRI"
+	constexpr Size headerSize = 4 + 8;
+
+	enum : std::uint8_t
+	{
+		EventKey = 1,
+		EventChar = 2,
+		EventButton = 3,
+		EventMove = 4,
+		EventScroll = 5,
+		EventEnter = 6
+	};
+
+	template <typename T>
+	T ReadLE(const unsigned char* data)
+	{
+		typename std::conditional<sizeof(T) == 8, std::uint64_t, std::uint32_t>::type bits = 0;
+		for (Size i = 0; i < sizeof(T); i++) bits |= decltype(bits)(data[i]) << (8 * i);
+		T value;
+		std::memcpy(&value, &bits, sizeof(T));
+		return value;
+	}
+
+	// Size of an event's payload, not including the type byte
+	Size PayloadSize(std::uint8_t type)
+	{
+		switch (type)
+		{
+			case EventKey:    return 9;
+			case EventChar:   return 4;
+			case EventButton: return 2;
+			case EventMove:   return 8;
+			case EventScroll: return 8;
+			case EventEnter:  return 1;
+			default:          return 0;
+		}
+	}
+
+	// Values that are passed on as enums must be in range, the sender is not
+	// trusted. Payloads are known to be long enough.
+	bool ValidPayload(std::uint8_t type, const unsigned char* payload)
+	{
+		switch (type)
+		{
+			case EventKey:
+				return payload[8] == GLFW_PRESS || payload[8] == GLFW_RELEASE || payload[8] == GLFW_REPEAT;
+			case EventButton:
+				return payload[0] <= GLFW_MOUSE_BUTTON_LAST &&
+					(payload[1] == GLFW_PRESS || payload[1] == GLFW_RELEASE);
+			default:
+				return true;
+		}
+	}
+
+	Double Seconds(RemoteInput::Clock::duration d)
+	{
+		return std::chrono::duration<Double>(d).count();
+	}
+}
+
+RemoteInput::RemoteInput(const RemoteInputArgs& args) :
+	target(args.target),
+	targetGeneration(0),
+	targetHandle(nullptr),
+	jitterBuffer(args.jitterBuffer),
+	socket(-1),
+	running(false),
+	haveOffset(false),
+	minOffset(0),
+	lastTransit(0.0)
+{
+	if (target == nullptr)
+	{
+		throw std::runtime_error("RemoteInput requires a target window.");
+	}
+
+	targetGeneration = GetWindowGeneration(target);
+	targetHandle = target->GetHandle();
+
+#ifdef VLFW_HAS_POSIX_SOCKETS
+	if (args.transport == RemoteInputTransport::UnixSocket)
+	{
+		sockaddr_un addr {};
+		addr.sun_family = AF_UNIX;
+
+		if (args.socketPath.empty() || args.socketPath.size() >= sizeof(addr.sun_path))
+		{
+			throw std::runtime_error("Invalid RemoteInput socket path: " + args.socketPath);
+		}
+
+		std::strncpy(addr.sun_path, args.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+		// Remove a stale socket left behind by a previous run, but nothing
+		// else that happens to be at the path
+		struct stat existing;
+		if (lstat(args.socketPath.c_str(), &existing) == 0)
+		{
+			if (!S_ISSOCK(existing.st_mode))
+			{
+				throw std::runtime_error("RemoteInput socket path exists and is not a socket: " + args.socketPath);
+			}
+
+			unlink(args.socketPath.c_str());
+		}
+
+		socket = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+		if (socket < 0) throw std::runtime_error("Failed to create RemoteInput socket.");
+
+		if (bind(socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+		{
+			close(socket);
+			throw std::runtime_error("Failed to bind RemoteInput socket: " + args.socketPath);
+		}
+
+		socketPath = args.socketPath;
+	}
+	else
+	{
+		sockaddr_in addr {};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(static_cast<std::uint16_t>(args.port));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+		if (socket < 0) throw std::runtime_error("Failed to create RemoteInput socket.");
+
+		if (bind(socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+		{
+			close(socket);
+			throw std::runtime_error("Failed to bind RemoteInput socket to port " + std::to_string(args.port));
+		}
+	}
+
+	running = true;
+	reciever = std::thread(&RemoteInput::Recieve, this);
+#else
+	throw std::runtime_error("RemoteInput is not supported on this platform.");
+#endif
+}
+
+RemoteInput::~RemoteInput()
+{
+#ifdef VLFW_HAS_POSIX_SOCKETS
+	running = false;
+	if (reciever.joinable()) reciever.join();
+
+	close(socket);
+	if (!socketPath.empty()) unlink(socketPath.c_str());
+#endif
+}
+
+// Runs on the reciever thread. Datagrams are timestamped as soon as they
+// arrive, and the event loop is woken once whenever buffered events become
+// due so delivery does not depend on other events arriving.
+void RemoteInput::Recieve()
+{
+#ifdef VLFW_HAS_POSIX_SOCKETS
+	std::vector<unsigned char> data(65536);
+
+	// Events due at or before this time have already woken the event loop
+	Clock::time_point woken = Clock::now();
+
+	auto unsignalled = [this, &woken]()
+	{
+		return std::find_if(buffer.cbegin(), buffer.cend(),
+			[&woken](const Pending& p) { return p.due > woken; });
+	};
+
+	while (running)
+	{
+		Int timeoutMs = 100;
+
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			auto next = unsignalled();
+			if (next != buffer.cend())
+			{
+				Double untilDue = Seconds(next->due - Clock::now());
+				timeoutMs = std::min(timeoutMs, std::max<Int>(0, static_cast<Int>(std::ceil(untilDue * 1000.0))));
+			}
+		}
+
+		pollfd pfd {};
+		pfd.fd = socket;
+		pfd.events = POLLIN;
+
+		if (poll(&pfd, 1, timeoutMs) > 0)
+		{
+			ssize_t size;
+			while ((size = recv(socket, data.data(), data.size(), MSG_DONTWAIT)) > 0)
+			{
+				Decode(data.data(), static_cast<Size>(size), Clock::now());
+			}
+		}
+
+		bool due = false;
+		Clock::time_point now = Clock::now();
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			auto next = unsignalled();
+			due = next != buffer.cend() && next->due <= now;
+		}
+
+		if (due)
+		{
+			woken = now;
+			glfwPostEmptyEvent();
+		}
+	}
+#endif
+}
+
+void RemoteInput::Decode(const unsigned char* data, Size size, Clock::time_point arrival)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+
+	if (size < headerSize || ReadLE<std::uint32_t>(data) != packetMagic)
+	{
+		stats.malformed++;
+		return;
+	}
+
+	// Estimate the clock offset between sender and reciever as the smallest
+	// difference seen, so the fastest packet defines zero transit time
+	std::int64_t sent = static_cast<std::int64_t>(ReadLE<std::uint64_t>(data + 4));
+	std::int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+		arrival.time_since_epoch()).count();
+	std::int64_t offset = now - sent;
+
+	if (!haveOffset || offset < minOffset)
+	{
+		minOffset = offset;
+		haveOffset = true;
+	}
+
+	Double transit = (offset - minOffset) / 1000000.0;
+	stats.jitter += (std::abs(transit - lastTransit) - stats.jitter) / 16.0;
+	lastTransit = transit;
+
+	Clock::time_point due = arrival +
+		std::chrono::duration_cast<Clock::duration>(std::chrono::duration<Double>(jitterBuffer - transit));
+
+	if (due < arrival)
+	{
+		stats.late++;
+		due = arrival;
+	}
+
+	// Validate the whole datagram before buffering any of it
+	Size n = headerSize;
+	while (n < size)
+	{
+		Size payload = PayloadSize(data[n]);
+		if (payload == 0 || size - n - 1 < payload || !ValidPayload(data[n], data + n + 1))
+		{
+			stats.malformed++;
+			return;
+		}
+		n += 1 + payload;
+	}
+
+	n = headerSize;
+	while (n < size)
+	{
+		Pending p {};
+		p.arrival = arrival;
+		p.due = due;
+		p.type = data[n++];
+
+		switch (p.type)
+		{
+			case EventKey:
+				p.a = ReadLE<std::int32_t>(data + n);
+				p.b = ReadLE<std::int32_t>(data + n + 4);
+				p.c = data[n + 8];
+				break;
+			case EventChar:
+				p.a = static_cast<Int>(ReadLE<std::uint32_t>(data + n));
+				break;
+			case EventButton:
+				p.a = data[n];
+				p.b = data[n + 1];
+				break;
+			case EventMove:
+			case EventScroll:
+				p.x = ReadLE<Float>(data + n);
+				p.y = ReadLE<Float>(data + n + 4);
+				break;
+			case EventEnter:
+				p.a = data[n];
+				break;
+		}
+
+		n += PayloadSize(p.type);
+		stats.recieved++;
+
+		// Keep the buffer ordered by delivery time. Packets mostly arrive
+		// in order, so search from the back.
+		auto it = buffer.end();
+		while (it != buffer.begin() && (it - 1)->due > p.due) it--;
+		buffer.insert(it, p);
+	}
+}
+
+// Queued with VLFWMain's injected input, which takes care of the target
+// window being destroyed before delivery
+void RemoteInput::Deliver(const Pending& p)
+{
+	InjectedInput input {};
+	input.window = reinterpret_cast<GLFWwindow*>(targetHandle);
+	input.a = p.a;
+	input.b = p.b;
+	input.c = p.c;
+	input.x = p.x;
+	input.y = p.y;
+
+	switch (p.type)
+	{
+		case EventKey:    input.type = InjectedType::Key; break;
+		case EventChar:   input.type = InjectedType::Char; break;
+		case EventButton: input.type = InjectedType::MouseButton; break;
+		case EventMove:   input.type = InjectedType::MouseMove; break;
+		case EventScroll: input.type = InjectedType::Scroll; break;
+		case EventEnter:  input.type = InjectedType::CursorEnter; break;
+		default:          return;
+	}
+
+	InjectInput(input);
+}
+
+void RemoteInput::OnEvent(const PreUpdateEvent&)
+{
+	std::vector<Pending> ready;
+	Clock::time_point now = Clock::now();
+
+	// Events for a window that has been destroyed are dropped, without
+	// touching the window
+	bool live = IsWindowLive(target, targetGeneration);
+
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+
+		while (!buffer.empty() && buffer.front().due <= now)
+		{
+			ready.push_back(buffer.front());
+			buffer.pop_front();
+		}
+
+		if (!live) return;
+
+		for (auto it = ready.cbegin(); it != ready.cend(); it++)
+		{
+			Double latency = Seconds(now - it->arrival);
+			stats.delivered++;
+			stats.meanLatency += (latency - stats.meanLatency) / stats.delivered;
+			stats.maxLatency = std::max(stats.maxLatency, latency);
+		}
+	}
+
+	// Deliver outside the lock, listeners may take a while
+	for (auto it = ready.cbegin(); it != ready.cend(); it++)
+	{
+		Deliver(*it);
+	}
+}
+
+void RemoteInput::SetTarget(Window* window)
+{
+	target = window;
+	targetGeneration = window ? GetWindowGeneration(window) : 0;
+	targetHandle = window ? window->GetHandle() : nullptr;
+}
+
+RemoteInputStats RemoteInput::GetStats()
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return stats;
+}
+
+void RemoteInput::SetJitterBuffer(Double seconds)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	jitterBuffer = seconds;
+}
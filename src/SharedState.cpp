@@ -0,0 +1,157 @@
+#include "VLFW/SharedState.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VLFW_HAS_POSIX_SHM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace vlk;
+using namespace vlfw;
+
+namespace
+{
+	// Identifies a region written by a compatible version of VLFW
+	constexpr std::uint32_t regionMagic = 0x564C4657; // "VLFW"
+	constexpr std::uint32_t regionVersion = (1u << 16) | sizeof(SharedInputState);
+
+	struct Region
+	{
+		// Odd while a write is in progress
+		std::atomic<std::uint32_t> sequence;
+		std::uint32_t magic;
+		std::uint32_t version;
+		SharedInputState state;
+	};
+
+	std::string RegionName(const std::string& name)
+	{
+		if (!name.empty() && name[0] == '/') return name;
+		return "/" + name;
+	}
+}
+
+SharedStatePublisher::SharedStatePublisher(const std::string& n) :
+	region(nullptr),
+	name(RegionName(n))
+{
+#ifdef VLFW_HAS_POSIX_SHM
+	int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Failed to create shared memory region: " + name);
+	}
+
+	if (ftruncate(fd, sizeof(Region)) != 0)
+	{
+		close(fd);
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Failed to size shared memory region: " + name);
+	}
+
+	void* mem = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (mem == MAP_FAILED)
+	{
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Failed to map shared memory region: " + name);
+	}
+
+	Region* r = new (mem) Region();
+	r->sequence.store(0, std::memory_order_relaxed);
+	r->magic = regionMagic;
+	r->version = regionVersion;
+	region = r;
+#else
+	throw std::runtime_error("Shared memory publication is not supported on this platform.");
+#endif
+}
+
+SharedStatePublisher::~SharedStatePublisher()
+{
+#ifdef VLFW_HAS_POSIX_SHM
+	munmap(region, sizeof(Region));
+	shm_unlink(name.c_str());
+#endif
+}
+
+void SharedStatePublisher::Publish(const SharedInputState& state)
+{
+	Region* r = reinterpret_cast<Region*>(region);
+
+	std::uint32_t seq = r->sequence.load(std::memory_order_relaxed);
+	r->sequence.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	std::memcpy(static_cast<void*>(&r->state), &state, sizeof(SharedInputState));
+
+	r->sequence.store(seq + 2, std::memory_order_release);
+}
+
+SharedStateReader::SharedStateReader(const std::string& n) :
+	region(nullptr)
+{
+#ifdef VLFW_HAS_POSIX_SHM
+	std::string name(RegionName(n));
+
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Failed to open shared memory region: " + name);
+	}
+
+	void* mem = mmap(nullptr, sizeof(Region), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (mem == MAP_FAILED)
+	{
+		throw std::runtime_error("Failed to map shared memory region: " + name);
+	}
+
+	const Region* r = reinterpret_cast<const Region*>(mem);
+	if (r->magic != regionMagic || r->version != regionVersion)
+	{
+		munmap(mem, sizeof(Region));
+		throw std::runtime_error("Shared memory region was published by an incompatible version of VLFW: " + name);
+	}
+
+	region = mem;
+#else
+	throw std::runtime_error("Shared memory publication is not supported on this platform.");
+#endif
+}
+
+SharedStateReader::~SharedStateReader()
+{
+#ifdef VLFW_HAS_POSIX_SHM
+	munmap(const_cast<void*>(region), sizeof(Region));
+#endif
+}
+
+bool SharedStateReader::Read(SharedInputState& out, Size maxAttempts) const
+{
+	const Region* r = reinterpret_cast<const Region*>(region);
+
+	for (Size i = 0; i < maxAttempts; i++)
+	{
+		std::uint32_t before = r->sequence.load(std::memory_order_acquire);
+
+		// Nothing published yet, or a write is in progress
+		if (before == 0) return false;
+		if (before & 1) continue;
+
+		std::memcpy(static_cast<void*>(&out), &r->state, sizeof(SharedInputState));
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (r->sequence.load(std::memory_order_relaxed) == before) return true;
+	}
+
+	return false;
+}
@@ -1,131 +1,1870 @@
 #include "VLFW/VLFW.hpp"
 #include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
 #include <stdexcept>
+#include <thread>
 #include <iostream>
 
 #define GLFW_INCLUDE_VULKAN
 #include "GLFW/glfw3.h"
+#include "Internal.hpp"
 #include "ValkyrieEngine/ValkyrieEngine.hpp"
 
+#ifdef _WIN32
+#define VLFW_GLAPI __stdcall
+#else
+#define VLFW_GLAPI
+#endif
+
 using namespace vlk;
 using namespace vlfw;
 
-namespace
-{
-	std::vector<Monitor*> monitorRegistry;
-	std::mutex mtx;
+namespace
+{
+	std::vector<Monitor*> monitorRegistry;
+	std::mutex mtx;
+
+	// Live windows, stored as a structure of arrays so the per-frame loop
+	// only touches the flags it needs. Rows are removed by swapping in the
+	// last row, each window stores its own row index.
+	struct WindowTable
+	{
+		std::vector<GLFWwindow*> handles;
+		std::vector<Window*> windows;
+		std::vector<ContextAPI> contextAPIs;
+		std::vector<std::uint8_t> needsSwap;
+		std::vector<std::uint8_t> closeRequested;
+		std::vector<std::uint8_t> minimized;
+		std::vector<std::uint8_t> dirty;
+		std::vector<ThrottlePolicy> throttle;
+
+		// Set for rows that are throttled this frame
+		std::vector<std::uint8_t> skip;
+
+		// Earliest time a row using ThrottlePolicy::Cap may be redrawn
+		std::vector<Double> nextFrame;
+
+		// Set for rows being redrawn by the current frame, so windows
+		// marked dirty while the frame is finishing are redrawn next frame
+		std::vector<std::uint8_t> redrawing;
+
+		// Value of registrations when the row was added, tells a window
+		// apart from one created later at the same address
+		std::vector<std::uint64_t> generations;
+
+		// Number of rows with closeRequested set
+		Size closeCount = 0;
+
+		// Number of rows with dirty set
+		Size dirtyCount = 0;
+
+		// Incremented whenever a window is added
+		std::uint64_t registrations = 0;
+
+		// Incremented whenever a window is removed
+		std::uint64_t unregistrations = 0;
+
+		inline Size Count() const { return windows.size(); }
+	} windowTable;
+
+	// False when using VLFWMainArgs::redrawOnDemand and not animating
+	bool redrawAll = true;
+
+	// Whether a row should be redrawn this frame
+	inline bool Redraw(Size i)
+	{
+		return !windowTable.skip[i] && (redrawAll || windowTable.dirty[i]);
+	}
+
+	// Windows whose throttle policy changed since the last frame
+	std::vector<Window*> throttleChanged;
+
+	// Seconds until a dirty window may be redrawn, or a negative value if
+	// none may be redrawn until its throttle policy changes
+	Double TimeUntilRedraw(Double now)
+	{
+		Double result = -1.0;
+		if (windowTable.dirtyCount == 0) return result;
+
+		for (Size i = 0; i < windowTable.Count(); i++)
+		{
+			if (!windowTable.dirty[i]) continue;
+
+			switch (windowTable.throttle[i])
+			{
+				case ThrottlePolicy::Continue:
+					return 0.0;
+
+				case ThrottlePolicy::Pause:
+					break;
+
+				case ThrottlePolicy::Cap:
+				{
+					Double t = std::max(windowTable.nextFrame[i] - now, 0.0);
+					if (t == 0.0) return t;
+					if (result < 0.0 || t < result) result = t;
+					break;
+				}
+			}
+		}
+
+		return result;
+	}
+
+	// OpenGL 3.2 / ARB_sync entry points, loaded through GLFW so VLFW does not
+	// need an OpenGL loader of its own. Sync objects are passed as void*.
+	typedef void* (VLFW_GLAPI* FenceSyncProc)(unsigned int condition, unsigned int flags);
+	typedef unsigned int (VLFW_GLAPI* ClientWaitSyncProc)(void* sync, unsigned int flags, std::uint64_t timeout);
+	typedef void (VLFW_GLAPI* DeleteSyncProc)(void* sync);
+
+	typedef const unsigned char* (VLFW_GLAPI* GetStringProc)(unsigned int name);
+
+	constexpr unsigned int glSyncGPUCommandsComplete = 0x9117;
+	constexpr unsigned int glSyncFlushCommandsBit =    0x00000001;
+	constexpr unsigned int glTimeoutExpired =          0x911B;
+	constexpr unsigned int glVersion =                 0x1F02;
+
+	struct GLSyncProcs
+	{
+		FenceSyncProc fenceSync = nullptr;
+		ClientWaitSyncProc clientWaitSync = nullptr;
+		DeleteSyncProc deleteSync = nullptr;
+	};
+
+	// Loads the sync entry points of the current context. Some platforms
+	// return entry points the context does not support, so they are left
+	// null unless the context is OpenGL 3.2, OpenGL ES 3.0 or has ARB_sync.
+	GLSyncProcs LoadSyncProcs()
+	{
+		GLSyncProcs procs;
+
+		GetStringProc getString = reinterpret_cast<GetStringProc>(glfwGetProcAddress("glGetString"));
+		if (getString == nullptr) return procs;
+
+		const char* version = reinterpret_cast<const char*>(getString(glVersion));
+		if (version == nullptr) return procs;
+
+		bool es = std::strncmp(version, "OpenGL ES ", 10) == 0;
+		if (es) version += 10;
+
+		Int major = 0;
+		Int minor = 0;
+		std::sscanf(version, "%d.%d", &major, &minor);
+
+		bool supported = es ? major >= 3 :
+			major > 3 || (major == 3 && minor >= 2) || glfwExtensionSupported("GL_ARB_sync");
+		if (!supported) return procs;
+
+		procs.fenceSync = reinterpret_cast<FenceSyncProc>(glfwGetProcAddress("glFenceSync"));
+		procs.clientWaitSync = reinterpret_cast<ClientWaitSyncProc>(glfwGetProcAddress("glClientWaitSync"));
+		procs.deleteSync = reinterpret_cast<DeleteSyncProc>(glfwGetProcAddress("glDeleteSync"));
+
+		if (!procs.fenceSync || !procs.clientWaitSync || !procs.deleteSync) procs = GLSyncProcs{};
+		return procs;
+	}
+
+	RenderSyncMode renderSyncMode = RenderSyncMode::Event;
+	Size maxFramesInFlight = 2;
+
+	// Outstanding fences of a window, oldest first, and the sync entry points
+	// of its context, loaded the first time the window is swapped
+	struct FenceRing
+	{
+		bool loaded = false;
+		GLSyncProcs procs;
+		std::deque<void*> syncs;
+	};
+
+	// The map is shared between the threads that may swap, each ring is only
+	// touched by the thread swapping that window
+	std::mutex fenceMtx;
+	std::map<GLFWwindow*, FenceRing> fences;
+
+	// Swaps the buffers of a window whose context is current on the calling
+	// thread. Using RenderSyncMode::Fence, first waits until fewer than
+	// maxFramesInFlight earlier frames are still being processed by the GPU.
+	void SwapWindow(GLFWwindow* window)
+	{
+		if (renderSyncMode != RenderSyncMode::Fence)
+		{
+			glfwSwapBuffers(window);
+			return;
+		}
+
+		FenceRing* ring;
+		{
+			std::lock_guard<std::mutex> guard(fenceMtx);
+			ring = &fences[window];
+		}
+
+		if (!ring->loaded)
+		{
+			ring->procs = LoadSyncProcs();
+			ring->loaded = true;
+		}
+
+		const GLSyncProcs& gl = ring->procs;
+
+		// Contexts without sync objects just swap
+		if (gl.fenceSync == nullptr)
+		{
+			glfwSwapBuffers(window);
+			return;
+		}
+
+		while (ring->syncs.size() >= maxFramesInFlight)
+		{
+			void* sync = ring->syncs.front();
+			ring->syncs.pop_front();
+
+			// Wait in 100ms slices, giving up on anything but a timeout
+			while (gl.clientWaitSync(sync, glSyncFlushCommandsBit, 100000000) == glTimeoutExpired);
+			gl.deleteSync(sync);
+		}
+
+		glfwSwapBuffers(window);
+
+		void* sync = gl.fenceSync(glSyncGPUCommandsComplete, 0);
+		if (sync) ring->syncs.push_back(sync);
+	}
+
+	// Windows to swap this frame
+	std::vector<GLFWwindow*> swapList;
+
+	// Swaps the buffers of several windows at once. Each window is swapped on
+	// its own thread, which makes the window's context current, swaps and
+	// releases it again. Threads are created as needed and kept around.
+	class SwapPool
+	{
+		std::vector<std::thread> threads;
+		std::mutex m;
+		std::condition_variable start;
+		std::condition_variable done;
+		std::vector<GLFWwindow*> jobs;
+		std::uint64_t generation = 0;
+		Size remaining = 0;
+		bool stopping = false;
+
+		void Run(Size index)
+		{
+			std::uint64_t seen = 0;
+			std::unique_lock<std::mutex> lk(m);
+
+			while (true)
+			{
+				start.wait(lk, [this, &seen]() { return stopping || generation != seen; });
+				if (stopping) return;
+
+				seen = generation;
+				if (index >= jobs.size()) continue;
+
+				GLFWwindow* window = jobs[index];
+				lk.unlock();
+
+				glfwMakeContextCurrent(window);
+				SwapWindow(window);
+				glfwMakeContextCurrent(nullptr);
+
+				lk.lock();
+				if (--remaining == 0) done.notify_one();
+			}
+		}
+
+		public:
+		~SwapPool()
+		{
+			{
+				std::lock_guard<std::mutex> guard(m);
+				stopping = true;
+			}
+
+			start.notify_all();
+			for (auto it = threads.begin(); it != threads.end(); it++) it->join();
+		}
+
+		// Blocks until every window has been swapped. No context may be
+		// current on the calling thread.
+		void Swap(const std::vector<GLFWwindow*>& windows)
+		{
+			std::unique_lock<std::mutex> lk(m);
+
+			while (threads.size() < windows.size())
+			{
+				threads.emplace_back(&SwapPool::Run, this, threads.size());
+			}
+
+			jobs = windows;
+			remaining = windows.size();
+			generation++;
+
+			start.notify_all();
+			done.wait(lk, [this]() { return remaining == 0; });
+		}
+	};
+
+	std::unique_ptr<SwapPool> swapPool;
+
+	// A window the render thread should draw
+	struct RenderJob
+	{
+		Window* window;
+		GLFWwindow* handle;
+		bool swap;
+	};
+
+	// Listeners of the render thread, held locked while they are called
+	std::mutex renderListenerMtx;
+	std::vector<VLFWMain::RenderListener*> renderListeners;
+
+	// Renders and swaps frames handed over by the main thread
+	class RenderThread
+	{
+		std::thread thread;
+		std::mutex m;
+		std::condition_variable cv;
+		std::vector<RenderJob> pending;
+		std::vector<RenderJob> rendering;
+		bool waitForRenderer;
+		bool hasFrame = false;
+		bool busy = false;
+		bool stopping = false;
+
+		void Run()
+		{
+			std::unique_lock<std::mutex> lk(m);
+
+			while (true)
+			{
+				cv.wait(lk, [this]() { return stopping || hasFrame; });
+				if (stopping) return;
+
+				std::swap(pending, rendering);
+				hasFrame = false;
+				busy = true;
+				lk.unlock();
+
+				Render();
+
+				lk.lock();
+				busy = false;
+				cv.notify_all();
+			}
+		}
+
+		void Render()
+		{
+			{
+				std::lock_guard<std::mutex> guard(renderListenerMtx);
+
+				for (auto it = rendering.cbegin(); it != rendering.cend(); it++)
+				{
+					if (it->swap) glfwMakeContextCurrent(it->handle);
+
+					for (auto l = renderListeners.cbegin(); l != renderListeners.cend(); l++)
+					{
+						(*l)->OnRender(VLFWMain::RenderEvent{it->window});
+					}
+				}
+
+				if (waitForRenderer && renderSyncMode == RenderSyncMode::Event)
+				{
+					for (auto l = renderListeners.cbegin(); l != renderListeners.cend(); l++)
+					{
+						(*l)->OnRenderWait(VLFWMain::RenderWaitEvent {});
+					}
+				}
+			}
+
+			for (auto it = rendering.cbegin(); it != rendering.cend(); it++)
+			{
+				if (!it->swap) continue;
+
+				glfwMakeContextCurrent(it->handle);
+				SwapWindow(it->handle);
+			}
+
+			glfwMakeContextCurrent(nullptr);
+			rendering.clear();
+		}
+
+		public:
+		RenderThread(bool wait) :
+			waitForRenderer(wait)
+		{
+			thread = std::thread(&RenderThread::Run, this);
+		}
+
+		~RenderThread()
+		{
+			{
+				std::lock_guard<std::mutex> guard(m);
+				stopping = true;
+			}
+
+			cv.notify_all();
+			thread.join();
+		}
+
+		// Replaces any frame that has not been started yet
+		void Submit(std::vector<RenderJob>& jobs)
+		{
+			{
+				std::lock_guard<std::mutex> guard(m);
+				std::swap(pending, jobs);
+				hasFrame = true;
+			}
+
+			jobs.clear();
+			cv.notify_all();
+		}
+
+		// Waits for the current frame to finish and drops the window from
+		// the next one
+		void Remove(Window* window)
+		{
+			std::unique_lock<std::mutex> lk(m);
+			cv.wait(lk, [this]() { return !busy; });
+
+			pending.erase(
+				std::remove_if(pending.begin(), pending.end(),
+					[window](const RenderJob& j) { return j.window == window; }),
+				pending.end());
+		}
+
+		void SetWaitForRenderer(bool wait)
+		{
+			std::lock_guard<std::mutex> guard(m);
+			waitForRenderer = wait;
+		}
+	};
+
+	std::unique_ptr<RenderThread> renderThread;
+	std::vector<RenderJob> renderJobs;
+
+	// Window synchronized to vertical blank in SwapMode::PrimaryVsync, and
+	// what the window table looked like when swap intervals were last set
+	GLFWwindow* vsyncWindow = nullptr;
+	Size vsyncSwapCount = 0;
+	std::uint64_t vsyncRegistrations = 0;
+
+	// Pacer of the live VLFWMain, if using VLFWMainArgs::framePacing
+	FramePacer* mainPacer = nullptr;
+
+	// Window the pacer follows, the first window whose buffers are swapped,
+	// going by the throttle state of the previous frame. With
+	// SwapMode::PrimaryVsync that is also the window synchronized to vertical
+	// blank. Returns nullptr if no window is being redrawn.
+	Window* PacedWindow()
+	{
+		for (Size i = 0; i < windowTable.Count(); i++)
+		{
+			if (windowTable.needsSwap[i] && !windowTable.minimized[i] && Redraw(i))
+			{
+				return windowTable.windows[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	// Number of commands posted to windows since they were last executed
+	std::atomic_uint postedCommands(0);
+
+	// Arena of the live VLFWMain, event payloads are allocated from it
+	FrameArena* eventArena = nullptr;
+	std::thread::id mainThread;
+
+	struct BufferedEvent
+	{
+		Window* window;
+		std::function<void()> send;
+
+		// Frame the event was buffered in, its payload belongs to that
+		// frame's arena
+		std::uint64_t frame;
+	};
+
+	// Counts calls to VLFWMain::ResetFrameArena()
+	std::uint64_t arenaFrame = 0;
+
+	// Contents of the frame arena from frames whose events are still
+	// buffered, oldest first. Released once all of a frame's events have
+	// been sent, then kept for reuse.
+	struct RetiredArena
+	{
+		std::uint64_t frame;
+		std::unique_ptr<FrameArena> arena;
+	};
+
+	std::deque<RetiredArena> retiredArenas;
+	std::vector<std::unique_ptr<FrameArena>> spareArenas;
+
+	// Spare arenas kept beyond this are freed
+	constexpr Size maxSpareArenas = 2;
+
+	// Events buffered by callbacks when using VLFWMainArgs::eventBudget
+	bool bufferingEvents = false;
+	std::deque<BufferedEvent> highEvents;
+	std::deque<BufferedEvent> lowEvents;
+
+	// Latest cursor position of a window while its MouseMoveEvent is buffered.
+	// Moves arriving before it is sent only update the position.
+	struct CursorMove
+	{
+		Vector2 position;
+		bool sent;
+	};
+
+	// Buffered cursor moves that later moves may still be merged into
+	std::vector<std::pair<Window*, std::shared_ptr<CursorMove>>> openMoves;
+
+	void SendCursorMove(Window* window, CursorMove& move)
+	{
+		if (move.sent) return;
+		move.sent = true;
+		RouteEvent(Window::MouseMoveEvent{window, move.position});
+	}
+
+	// Sends buffered events from the front of a queue until it is empty or
+	// the deadline has passed, at least one event is always sent. Listeners
+	// may buffer more events or destroy windows while this runs.
+	Size SendQueuedEvents(std::deque<BufferedEvent>& queue, Double deadline)
+	{
+		Size count = 0;
+
+		while (!queue.empty() && (count == 0 || glfwGetTime() < deadline))
+		{
+			BufferedEvent ev = std::move(queue.front());
+			queue.pop_front();
+			ev.send();
+			count++;
+		}
+
+		return count;
+	}
+
+	// Characters typed since text input was last sent, when using
+	// VLFWMainArgs::batchTextInput
+	bool batchingText = false;
+	std::vector<std::pair<Window*, char32_t>> typedText;
+
+	// Encodes UTF-32 as UTF-8, writing at most four bytes per codepoint.
+	// Invalid codepoints are replaced with U+FFFD.
+	Size EncodeUTF8(const char32_t* in, Size count, char* out)
+	{
+		char* start = out;
+		Size i = 0;
+
+		while (i < count)
+		{
+			// Typed text is mostly ASCII, copy runs of it four at a time
+			while (i + 4 <= count && (in[i] | in[i + 1] | in[i + 2] | in[i + 3]) < 0x80)
+			{
+				out[0] = static_cast<char>(in[i]);
+				out[1] = static_cast<char>(in[i + 1]);
+				out[2] = static_cast<char>(in[i + 2]);
+				out[3] = static_cast<char>(in[i + 3]);
+				out += 4;
+				i += 4;
+			}
+
+			if (i == count) break;
+
+			char32_t c = in[i++];
+			if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) c = 0xFFFD;
+
+			if (c < 0x80)
+			{
+				*out++ = static_cast<char>(c);
+			}
+			else if (c < 0x800)
+			{
+				*out++ = static_cast<char>(0xC0 | (c >> 6));
+				*out++ = static_cast<char>(0x80 | (c & 0x3F));
+			}
+			else if (c < 0x10000)
+			{
+				*out++ = static_cast<char>(0xE0 | (c >> 12));
+				*out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				*out++ = static_cast<char>(0x80 | (c & 0x3F));
+			}
+			else
+			{
+				*out++ = static_cast<char>(0xF0 | (c >> 18));
+				*out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+				*out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				*out++ = static_cast<char>(0x80 | (c & 0x3F));
+			}
+		}
+
+		return static_cast<Size>(out - start);
+	}
+
+	// Number of events posted with VLFWMain::PostEvent() since they were last
+	// sent
+	std::atomic_uint postedEventCount(0);
+
+	// Set by callbacks when there has been input or a window change
+	bool activitySeen = false;
+
+	struct Timer
+	{
+		Double deadline;
+		Size id;
+
+		// Orders the heap so the earliest deadline is at the front
+		inline bool operator>(const Timer& other) const
+		{
+			return deadline > other.deadline;
+		}
+	};
+
+	// Min-heap of pending deadlines. Cancelled timers are only removed from
+	// timerPeriods and are discarded once they reach the front.
+	std::vector<Timer> timerHeap;
+	std::map<Size, Double> timerPeriods;
+	Size nextTimerID = 1;
+
+	void PushTimer(Double deadline, Size id)
+	{
+		timerHeap.push_back(Timer{deadline, id});
+		std::push_heap(timerHeap.begin(), timerHeap.end(), std::greater<Timer>());
+	}
+
+	Timer PopTimer()
+	{
+		std::pop_heap(timerHeap.begin(), timerHeap.end(), std::greater<Timer>());
+		Timer t = timerHeap.back();
+		timerHeap.pop_back();
+		return t;
+	}
+
+	// Seconds until the next timer expires, or a negative value if there
+	// are no timers
+	Double TimeUntilTimer(Double now)
+	{
+		while (!timerHeap.empty() && timerPeriods.count(timerHeap.front().id) == 0)
+		{
+			PopTimer();
+		}
+
+		if (timerHeap.empty()) return -1.0;
+		return std::max(timerHeap.front().deadline - now, 0.0);
+	}
+
+	// Time at which a write held back by a rate limit may be applied, or a
+	// negative value if there is none. Requested again each frame the write
+	// is still held back.
+	Double deferredWriteTime = -1.0;
+
+	// Shortens the wait for events so the main thread wakes within the given
+	// number of seconds, or stops it waiting if that is no time at all
+	void WakeWithin(Double seconds, WaitMode& mode, Double& timeout)
+	{
+		if (seconds < 0.0) return;
+
+		if (seconds == 0.0)
+		{
+			mode = WaitMode::Poll;
+		}
+		else if (timeout <= 0.0 || seconds < timeout)
+		{
+			timeout = seconds;
+		}
+	}
+
+	// True while the main thread is blocked waiting for events
+	std::atomic_bool waitingForEvents(false);
+
+	std::mutex injectMtx;
+	std::vector<InjectedInput> injected;
+
+	// Swapped with injected each frame so neither vector has to reallocate
+	// once it has grown to the injection rate
+	std::vector<InjectedInput> delivering;
+
+
+	// Queue drained by the main thread after window events, see
+	// VLFWMain::PostEvent()
+	CommandQueue* mainEvents = nullptr;
+
+	void PostToMainThread(std::function<void()> command)
+	{
+		mainEvents->Push(std::move(command));
+		postedEventCount.fetch_add(1);
+		if (waitingForEvents.load()) glfwPostEmptyEvent();
+	}
+
+	// Dropped files waiting to be mapped. The flag is only touched on the
+	// main thread and is set if the window is destroyed first.
+	struct DropJob
+	{
+		Window* window;
+		std::vector<std::string> paths;
+		std::shared_ptr<bool> cancelled;
+	};
+
+	std::vector<std::pair<Window*, std::shared_ptr<bool>>> pendingDrops;
+
+	// Maps dropped files on a background thread and posts the result back
+	// to the main thread
+	class FileMapper
+	{
+		std::thread thread;
+		std::mutex m;
+		std::condition_variable cv;
+		std::deque<DropJob> jobs;
+		bool stopping = false;
+
+		void Run()
+		{
+			std::unique_lock<std::mutex> lk(m);
+
+			while (true)
+			{
+				cv.wait(lk, [this]() { return stopping || !jobs.empty(); });
+				if (stopping) return;
+
+				DropJob job = std::move(jobs.front());
+				jobs.pop_front();
+				lk.unlock();
+
+				Map(job);
+
+				lk.lock();
+			}
+		}
+
+		void Map(const DropJob& job)
+		{
+			Window::FileDropReadyEvent ev{job.window, {}, {}};
+
+			for (auto it = job.paths.cbegin(); it != job.paths.cend(); it++)
+			{
+				try
+				{
+					// Page the file in here, mapping alone reads nothing
+					std::shared_ptr<const MappedFile> file = std::make_shared<const MappedFile>(*it);
+					file->Prefetch();
+					ev.files.push_back(std::move(file));
+				}
+				catch (const std::runtime_error&)
+				{
+					ev.failedPaths.push_back(*it);
+				}
+			}
+
+			std::shared_ptr<bool> cancelled = job.cancelled;
+
+			PostToMainThread([ev, cancelled]()
+			{
+				if (*cancelled) return;
+
+				pendingDrops.erase(
+					std::remove_if(pendingDrops.begin(), pendingDrops.end(),
+						[&cancelled](const std::pair<Window*, std::shared_ptr<bool>>& p)
+						{ return p.second == cancelled; }),
+					pendingDrops.end());
+
+				RouteEvent(ev);
+			});
+		}
+
+		public:
+		FileMapper()
+		{
+			thread = std::thread(&FileMapper::Run, this);
+		}
+
+		~FileMapper()
+		{
+			{
+				std::lock_guard<std::mutex> guard(m);
+				stopping = true;
+			}
+
+			cv.notify_all();
+			thread.join();
+		}
+
+		void Submit(DropJob job)
+		{
+			{
+				std::lock_guard<std::mutex> guard(m);
+				jobs.push_back(std::move(job));
+			}
+
+			cv.notify_one();
+		}
+	};
+
+	std::unique_ptr<FileMapper> fileMapper;
+}
+
+void RegisterWindow(Window* window)
+{
+	ContextAPI api = window->GetContextAPI();
+
+	WindowAccess::TableIndex(window) = windowTable.Count();
+	windowTable.registrations++;
+	windowTable.handles.push_back(reinterpret_cast<GLFWwindow*>(window->GetHandle()));
+	windowTable.windows.push_back(window);
+	windowTable.contextAPIs.push_back(api);
+
+	// Can only swap buffers of a window with an OpenGL or ES context
+	windowTable.needsSwap.push_back(api == ContextAPI::OpenGL || api == ContextAPI::OpenGLES);
+	windowTable.closeRequested.push_back(false);
+	windowTable.minimized.push_back(window->IsMinimized());
+
+	// A new window has never been drawn, unless it starts out minimized
+	windowTable.dirty.push_back(!windowTable.minimized.back());
+	if (windowTable.dirty.back()) windowTable.dirtyCount++;
+
+	ThrottlePolicy policy = window->GetThrottlePolicy();
+	windowTable.throttle.push_back(policy);
+	windowTable.skip.push_back(policy == ThrottlePolicy::Pause);
+	windowTable.nextFrame.push_back(0.0);
+	windowTable.redrawing.push_back(false);
+	windowTable.generations.push_back(windowTable.registrations);
+
+	// The render thread needs to be able to make the context current
+	if (renderThread) glfwMakeContextCurrent(nullptr);
+}
+
+void UnregisterWindow(Window* window)
+{
+	windowTable.unregistrations++;
+
+	if (renderThread) renderThread->Remove(window);
+	if (mainPacer && mainPacer->GetWindow() == window) mainPacer->SetWindow(nullptr);
+
+	// Sync objects belong to the context's share group, which outlives this
+	// window if its context is shared, so delete them while the window's
+	// context still exists. The render thread has released the context.
+	{
+		GLFWwindow* handle = reinterpret_cast<GLFWwindow*>(window->GetHandle());
+		FenceRing ring;
+
+		{
+			std::lock_guard<std::mutex> guard(fenceMtx);
+			auto found = fences.find(handle);
+
+			if (found != fences.end())
+			{
+				ring = std::move(found->second);
+				fences.erase(found);
+			}
+		}
+
+		if (!ring.syncs.empty())
+		{
+			GLFWwindow* previous = glfwGetCurrentContext();
+			glfwMakeContextCurrent(handle);
+
+			for (auto it = ring.syncs.cbegin(); it != ring.syncs.cend(); it++)
+			{
+				ring.procs.deleteSync(*it);
+			}
+
+			glfwMakeContextCurrent(previous);
+		}
+	}
+
+	Size i = WindowAccess::TableIndex(window);
+	Size last = windowTable.Count() - 1;
+
+	if (windowTable.closeRequested[i]) windowTable.closeCount--;
+	if (windowTable.dirty[i]) windowTable.dirtyCount--;
+
+	if (i != last)
+	{
+		windowTable.handles[i] = windowTable.handles[last];
+		windowTable.windows[i] = windowTable.windows[last];
+		windowTable.contextAPIs[i] = windowTable.contextAPIs[last];
+		windowTable.needsSwap[i] = windowTable.needsSwap[last];
+		windowTable.closeRequested[i] = windowTable.closeRequested[last];
+		windowTable.minimized[i] = windowTable.minimized[last];
+		windowTable.dirty[i] = windowTable.dirty[last];
+		windowTable.throttle[i] = windowTable.throttle[last];
+		windowTable.skip[i] = windowTable.skip[last];
+		windowTable.nextFrame[i] = windowTable.nextFrame[last];
+		windowTable.redrawing[i] = windowTable.redrawing[last];
+		windowTable.generations[i] = windowTable.generations[last];
+		WindowAccess::TableIndex(windowTable.windows[i]) = i;
+	}
+
+	windowTable.handles.pop_back();
+	windowTable.windows.pop_back();
+	windowTable.contextAPIs.pop_back();
+	windowTable.needsSwap.pop_back();
+	windowTable.closeRequested.pop_back();
+	windowTable.minimized.pop_back();
+	windowTable.dirty.pop_back();
+	windowTable.throttle.pop_back();
+	windowTable.skip.pop_back();
+	windowTable.nextFrame.pop_back();
+	windowTable.redrawing.pop_back();
+	windowTable.generations.pop_back();
+
+	throttleChanged.erase(
+		std::remove(throttleChanged.begin(), throttleChanged.end(), window),
+		throttleChanged.end());
+
+	// Results still being mapped are discarded when they arrive
+	pendingDrops.erase(
+		std::remove_if(pendingDrops.begin(), pendingDrops.end(),
+			[window](const std::pair<Window*, std::shared_ptr<bool>>& p)
+			{
+				if (p.first == window) *p.second = true;
+				return p.first == window;
+			}),
+		pendingDrops.end());
+
+	typedText.erase(
+		std::remove_if(typedText.begin(), typedText.end(),
+			[window](const std::pair<Window*, char32_t>& c) { return c.first == window; }),
+		typedText.end());
+
+	auto sentTo = [window](const BufferedEvent& ev) { return ev.window == window; };
+	highEvents.erase(std::remove_if(highEvents.begin(), highEvents.end(), sentTo), highEvents.end());
+	lowEvents.erase(std::remove_if(lowEvents.begin(), lowEvents.end(), sentTo), lowEvents.end());
+
+	openMoves.erase(
+		std::remove_if(openMoves.begin(), openMoves.end(),
+			[window](const std::pair<Window*, std::shared_ptr<CursorMove>>& m) { return m.first == window; }),
+		openMoves.end());
+}
+
+std::uint64_t GetWindowGeneration(const Window* window)
+{
+	Size i = WindowAccess::TableIndex(window);
+	if (i >= windowTable.Count() || windowTable.windows[i] != window) return 0;
+
+	return windowTable.generations[i];
+}
+
+std::uint64_t GetWindowUnregistrations()
+{
+	return windowTable.unregistrations;
+}
+
+bool IsWindowLive(const Window* window, std::uint64_t generation)
+{
+	if (generation == 0) return false;
+
+	// The window may be gone, so its row index can not be read
+	for (Size i = 0; i < windowTable.Count(); i++)
+	{
+		if (windowTable.windows[i] == window) return windowTable.generations[i] == generation;
+	}
+
+	return false;
+}
+
+void SetWindowCloseRequested(Window* window, bool requested)
+{
+	Size i = WindowAccess::TableIndex(window);
+
+	// Windows still being constructed are not in the table yet
+	if (i >= windowTable.Count() || windowTable.windows[i] != window) return;
+
+	if (windowTable.closeRequested[i] != requested)
+	{
+		windowTable.closeRequested[i] = requested;
+		if (requested) windowTable.closeCount++;
+		else windowTable.closeCount--;
+	}
+}
+
+void SetWindowMinimized(Window* window, bool minimized)
+{
+	Size i = WindowAccess::TableIndex(window);
+	if (i >= windowTable.Count() || windowTable.windows[i] != window) return;
+
+	windowTable.minimized[i] = minimized;
+
+	// A minimized window shows nothing, so it is never dirty and can not
+	// keep redrawOnDemand from waiting. It is redrawn once restored.
+	if (windowTable.dirty[i] == minimized)
+	{
+		windowTable.dirty[i] = !minimized;
+		if (minimized) windowTable.dirtyCount--;
+		else windowTable.dirtyCount++;
+	}
+}
+
+void MarkWindowDirty(GLFWwindow* handle)
+{
+	Window* window = reinterpret_cast<Window*>(glfwGetWindowUserPointer(handle));
+	if (window == nullptr) return;
+
+	Size i = WindowAccess::TableIndex(window);
+	if (i >= windowTable.Count() || windowTable.windows[i] != window) return;
+
+	if (!windowTable.dirty[i] && !windowTable.minimized[i])
+	{
+		windowTable.dirty[i] = true;
+		windowTable.dirtyCount++;
+	}
+}
+
+bool WindowNeedsRedraw(const Window* window)
+{
+	Size i = WindowAccess::TableIndex(window);
+	if (i >= windowTable.Count() || windowTable.windows[i] != window) return true;
+
+	return Redraw(i);
+}
+
+void NotifyActivity()
+{
+	activitySeen = true;
+}
+
+void NotifyWindowCommandPosted()
+{
+	postedCommands.fetch_add(1);
+	if (waitingForEvents.load()) glfwPostEmptyEvent();
+}
+
+bool IsBufferingEvents()
+{
+	return bufferingEvents;
+}
+
+void BufferEvent(EventPriority priority, Window* window, std::function<void()> send)
+{
+	if (priority == EventPriority::High)
+	{
+		highEvents.push_back(BufferedEvent{window, std::move(send), arenaFrame});
+	}
+	else
+	{
+		lowEvents.push_back(BufferedEvent{window, std::move(send), arenaFrame});
+	}
+}
+
+void BufferCursorMove(Window* window, const Vector2& position)
+{
+	auto open = std::find_if(openMoves.begin(), openMoves.end(),
+		[window](const std::pair<Window*, std::shared_ptr<CursorMove>>& m) { return m.first == window; });
+
+	if (open != openMoves.end() && !open->second->sent)
+	{
+		open->second->position = position;
+		return;
+	}
+
+	std::shared_ptr<CursorMove> move = std::make_shared<CursorMove>(CursorMove{position, false});
+
+	if (open != openMoves.end()) open->second = move;
+	else openMoves.emplace_back(window, move);
+
+	lowEvents.push_back(BufferedEvent{window, [window, move]() { SendCursorMove(window, *move); }, arenaFrame});
+}
+
+void PromoteCursorMove(Window* window)
+{
+	auto open = std::find_if(openMoves.begin(), openMoves.end(),
+		[window](const std::pair<Window*, std::shared_ptr<CursorMove>>& m) { return m.first == window; });
+
+	if (open == openMoves.end()) return;
+
+	// The low priority entry does nothing once this one has been sent
+	std::shared_ptr<CursorMove> move = open->second;
+	openMoves.erase(open);
+
+	if (!move->sent)
+	{
+		highEvents.push_back(BufferedEvent{window, [window, move]() { SendCursorMove(window, *move); }, arenaFrame});
+	}
+}
+
+bool BufferTextInput(Window* window, char32_t codepoint)
+{
+	if (!batchingText) return false;
+
+	typedText.push_back(std::make_pair(window, codepoint));
+	return true;
+}
+
+void MapDroppedFiles(Window* window, const ArenaString* paths, Size count)
+{
+	if (!fileMapper) return;
+
+	DropJob job{window, std::vector<std::string>(), std::make_shared<bool>(false)};
+	job.paths.reserve(count);
+	for (Size i = 0; i < count; i++) job.paths.push_back(paths[i].ToString());
+
+	pendingDrops.push_back(std::make_pair(window, job.cancelled));
+	fileMapper->Submit(std::move(job));
+}
+
+void WakeForDeferredWrite(Double time)
+{
+	if (deferredWriteTime < 0.0 || time < deferredWriteTime) deferredWriteTime = time;
+}
+
+FrameArena* GetEventArena()
+{
+	return eventArena;
+}
+
+void InjectInput(const InjectedInput& input)
+{
+	bool wasEmpty;
+	{
+		std::lock_guard<std::mutex> guard(injectMtx);
+		wasEmpty = injected.empty();
+		injected.push_back(input);
+	}
+
+	// Wake the main thread if it is waiting for events. Only the first
+	// injection since the last delivery needs to, which keeps the cost
+	// down at high injection rates.
+	if (wasEmpty) glfwPostEmptyEvent();
+}
+
+void DiscardInjectedInput(GLFWwindow* window)
+{
+	std::lock_guard<std::mutex> guard(injectMtx);
+	injected.erase(
+		std::remove_if(injected.begin(), injected.end(),
+			[window](const InjectedInput& i) { return i.window == window; }),
+		injected.end());
+
+	// A listener may destroy the window while its input is being
+	// delivered, the rest of the batch is skipped
+	for (auto it = delivering.begin(); it != delivering.end(); it++)
+	{
+		if (it->window == window) it->window = nullptr;
+	}
+}
+
+void ErrorCallback(Int errorCode, const char* what)
+{
+	// Reported at the end of the frame along with other diagnostics
+	if (IsCollectingDiagnostics())
+	{
+		ReportDiagnostic(vlfw::DiagnosticSource::GLFW, vlfw::DiagnosticSeverity::Error, errorCode, what, std::strlen(what));
+		return;
+	}
+
+	// GLFW's string is only valid during the callback, and the arena may
+	// only be used on the main thread
+	ArenaString str{what, std::strlen(what)};
+	if (eventArena != nullptr && std::this_thread::get_id() == mainThread)
+	{
+		str = eventArena->Copy(what, str.length);
+	}
+
+	SendEvent(vlfw::ErrorEvent{errorCode, str});
+}
+
+void MonitorConnectedCallback(GLFWmonitor* monitor, Int event)
+{
+	if (event == GLFW_CONNECTED)
+	{
+		Monitor* monitorObject = new Monitor(monitor);
+		SendEvent(Monitor::ConnectEvent{monitorObject});
+
+		// Add monitor to registry
+		monitorRegistry.push_back(monitorObject);
+	}
+	else if (event == GLFW_DISCONNECTED)
+	{
+		Monitor* monitorObject = reinterpret_cast<Monitor*>(glfwGetMonitorUserPointer(monitor));
+		SendEvent(Monitor::DisconnectEvent{monitorObject});
+
+		// Remove monitor from registry
+		monitorRegistry.erase(
+			std::find(monitorRegistry.begin(), monitorRegistry.end(), monitorObject));
+
+		// Delete monitor object
+		delete monitorObject;
+	}
+}
+
+VLFWMain::VLFWMain(const VLFWMainArgs& args) :
+	lock(mtx, std::try_to_lock)
+{
+	if (!lock.owns_lock())
+	{
+		throw std::runtime_error("Multiple concurrent instances of VLFWMain are disallowed.");
+		return;
+	}
+	
+	eventArena = &frameArena;
+	mainThread = std::this_thread::get_id();
+	if (args.diagnostics) StartDiagnostics(args.diagnosticsArgs);
+	glfwSetErrorCallback(ErrorCallback);
+
+	glfwInit();
+	glfwSetMonitorCallback(MonitorConnectedCallback);
+
+	{ // Set Up monitors
+		Int monitorCount;
+		GLFWmonitor** monitors = glfwGetMonitors(&monitorCount);
+		
+		monitorRegistry.clear();
+		monitorRegistry.reserve(monitorCount);
+
+		for (Int i = 0; i < monitorCount; i++)
+		{
+			Monitor* monitor = new Monitor(monitors[i]);
+			monitorRegistry.push_back(monitor);
+		}
+	}
+
+	waitMode = args.waitMode;
+	waitTimeout = args.waitTimeout;
+	idlePeriod = args.idlePeriod;
+	redrawOnDemand = args.redrawOnDemand;
+	lateLatch = args.lateLatch;
+	eventBudget = args.eventBudget;
+	batchTextInput = args.batchTextInput;
+	batchingText = batchTextInput;
+	bufferingEvents = eventBudget > 0.0;
+	eventStats = EventStats{};
+	lateLatchBudget = args.lateLatchBudget;
+	animating = false;
+	lastActivity = glfwGetTime();
+	waitForRenderer = args.waitForRenderer;
+	swapMode = args.swapMode;
+	renderSyncMode = args.renderSyncMode;
+	maxFramesInFlight = std::max<Size>(args.maxFramesInFlight, 1);
+
+	if (args.renderThread) renderThread.reset(new RenderThread(waitForRenderer));
+
+	mainEvents = &postedEvents;
+	if (args.mapDroppedFiles) fileMapper.reset(new FileMapper());
+
+	if (args.framePacing) pacer.reset(new FramePacer(args.framePacer));
+	mainPacer = pacer.get();
+	//glfwSwapInterval(args.swapInterval);
+
+	if (!args.sharedStateName.empty())
+	{
+		publisher.reset(new SharedStatePublisher(args.sharedStateName));
+		sharedState = SharedInputState{};
+	}
+}
+
+VLFWMain::~VLFWMain()
+{
+	renderThread.reset();
+	renderJobs.clear();
+	fileMapper.reset();
+	pendingDrops.clear();
+	mainEvents = nullptr;
+	timerHeap.clear();
+	timerPeriods.clear();
+	highEvents.clear();
+	lowEvents.clear();
+	openMoves.clear();
+	bufferingEvents = false;
+	retiredArenas.clear();
+	spareArenas.clear();
+	eventArena = nullptr;
+	typedText.clear();
+	batchingText = false;
+	swapPool.reset();
+	vsyncWindow = nullptr;
+	vsyncSwapCount = 0;
+	mainPacer = nullptr;
+	monitorRegistry.clear();
+
+	glfwTerminate();
+	StopDiagnostics();
+}
+
+VLFWMain::RenderListener::RenderListener()
+{
+	std::lock_guard<std::mutex> guard(renderListenerMtx);
+	renderListeners.push_back(this);
+}
+
+VLFWMain::RenderListener::~RenderListener()
+{
+	std::lock_guard<std::mutex> guard(renderListenerMtx);
+	renderListeners.erase(std::remove(renderListeners.begin(), renderListeners.end(), this), renderListeners.end());
+}
+
+void VLFWMain::RenderListener::OnRenderWait(const RenderWaitEvent&) { }
+
+// Process Inputs
+void VLFWMain::OnEvent(const vlk::PreUpdateEvent&)
+{
+	// Process Events
+	// TODO: find a way to expose event processing
+	// TODO: find a way to expose clipboard functionality
+	
+	// Start the frame as late as possible, before input is sampled
+	if (pacer && !renderThread)
+	{
+		// Keep following the last window while nothing is redrawn
+		Window* paced = PacedWindow();
+		if (paced) pacer->SetWindow(paced);
+
+		pacer->WaitForFrameStart();
+	}
+
+	// Run commands posted from other threads before processing events
+	if (postedCommands.exchange(0) > 0)
+	{
+		// Commands may create or destroy windows, so iterate over a copy
+		std::vector<Window*> windows(windowTable.windows);
+
+		for (auto it = windows.cbegin(); it != windows.cend(); it++)
+		{
+			(*it)->ExecutePosted();
+		}
+	}
+
+	WaitMode mode = waitMode;
+	Double timeout = waitTimeout;
+	Double now = glfwGetTime();
+
+	if (mode == WaitMode::Adaptive)
+	{
+		// Activity since the last frame, such as a redraw requested
+		// during the update, has not reset lastActivity yet
+		bool idle = !animating && !activitySeen && now - lastActivity >= idlePeriod;
+		mode = idle ? WaitMode::Wait : WaitMode::Poll;
+	}
+
+	// Only block when there is nothing left to draw, and wake up in time
+	// for throttled windows that are waiting to be redrawn
+	if (redrawOnDemand)
+	{
+		Double next = animating ? 0.0 : TimeUntilRedraw(now);
+		mode = next == 0.0 ? WaitMode::Poll : WaitMode::Wait;
+
+		if (next > 0.0 && (timeout <= 0.0 || next < timeout)) timeout = next;
+	}
+
+	// Wake up in time for the next timer, and for writes held back by a
+	// rate limit, which are applied at the end of the frame
+	WakeWithin(TimeUntilTimer(now), mode, timeout);
+
+	if (deferredWriteTime >= 0.0)
+	{
+		WakeWithin(std::max(deferredWriteTime - now, 0.0), mode, timeout);
+		deferredWriteTime = -1.0;
+	}
+
+	// Events deferred by the budget or by late latching are already here,
+	// waiting could hold them back until an unrelated event arrives
+	if (!highEvents.empty() || !lowEvents.empty() || !typedText.empty())
+	{
+		mode = WaitMode::Poll;
+	}
+
+	if (mode == WaitMode::Poll)
+	{
+		glfwPollEvents();
+	}
+	else
+	{
+		// Publish that we are about to wait before checking for commands,
+		// so a command posted in between either is seen here or wakes us
+		waitingForEvents.store(true);
+
+		if (postedCommands.load() > 0 || postedEventCount.load() > 0)
+		{
+			glfwPollEvents();
+		}
+		else if (timeout > 0.0)
+		{
+			glfwWaitEventsTimeout(timeout);
+		}
+		else
+		{
+			glfwWaitEvents();
+		}
+
+		waitingForEvents.store(false);
+	}
+
+	DeliverInjectedInput();
+
+	SendTextInput();
+
+	SendBufferedEvents();
+
+	if (postedEventCount.exchange(0) > 0) postedEvents.Execute();
+
+	FireTimers();
+
+	UpdateThrottling();
+
+	if (activitySeen)
+	{
+		lastActivity = glfwGetTime();
+		activitySeen = false;
+	}
+
+	if (publisher) PublishSharedState();
+}
+
+void VLFWMain::DeliverInjectedInput()
+{
+	{
+		std::lock_guard<std::mutex> guard(injectMtx);
+		if (injected.empty()) return;
+		std::swap(injected, delivering);
+	}
+
+	for (auto it = delivering.cbegin(); it != delivering.cend(); it++)
+	{
+		// Discarded by a window destroyed during delivery
+		if (it->window == nullptr) continue;
+
+		switch (it->type)
+		{
+			case InjectedType::Key:
+				KeyCallback(it->window, it->a, it->b, it->c, 0);
+				break;
+			case InjectedType::Char:
+				CharCallback(it->window, static_cast<UInt>(it->a));
+				break;
+			case InjectedType::MouseButton:
+				MouseButtonCallback(it->window, it->a, it->b, 0);
+				break;
+			case InjectedType::MouseMove:
+				CursorPosCallback(it->window, it->x, it->y);
+				break;
+			case InjectedType::Scroll:
+				ScrollCallback(it->window, it->x, it->y);
+				break;
+			case InjectedType::CursorEnter:
+				CursorEnterCallback(it->window, it->a);
+				break;
+		}
+	}
+
+	delivering.clear();
 }
 
-void ErrorCallback(Int errorCode, const char* what)
+// Publish after events have been processed so pressed and released states
+// match what the application sees this frame
+void VLFWMain::PublishSharedState()
 {
-	SendEvent(vlfw::ErrorEvent{errorCode, std::string(what)});
+	sharedState.frame++;
+	sharedState.input.tick = sharedState.frame;
+	KeyboardMain::WriteSnapshot(sharedState.input);
+	MouseMain::WriteSnapshot(sharedState.input);
+
+	std::uint32_t count = 0;
+
+	for (Size i = 0; i < windowTable.Count() && count < SharedInputState::MaxWindows; i++)
+	{
+		const Window* c = windowTable.windows[i];
+		SharedWindowState& w = sharedState.windows[count++];
+		Point<Int> size = c->GetSize();
+		Point<Int> fbSize = c->GetFramebufferSize();
+		Point<Int> pos = c->GetPosition();
+
+		w.id = reinterpret_cast<std::uintptr_t>(windowTable.handles[i]);
+		w.width = size.X();
+		w.height = size.Y();
+		w.framebufferWidth = fbSize.X();
+		w.framebufferHeight = fbSize.Y();
+		w.x = pos.X();
+		w.y = pos.Y();
+		w.focused = c->IsFocused();
+		w.minimized = windowTable.minimized[i];
+		w.maximized = c->IsMaximized();
+		w.visible = c->IsVisible();
+	}
+
+	sharedState.windowCount = count;
+	publisher->Publish(sharedState);
 }
 
-void MonitorConnectedCallback(GLFWmonitor* monitor, Int event)
+// Apply deferred writes, swap buffers, close windows
+void VLFWMain::OnEvent(const vlk::PostUpdateEvent&)
 {
-	if (event == GLFW_CONNECTED)
+	if (renderThread)
 	{
-		Monitor* monitorObject = new Monitor(monitor);
-		SendEvent(Monitor::ConnectEvent{monitorObject});
+		SubmitRenderFrame();
+		return;
+	}
 
-		// Add monitor to registry
-		monitorRegistry.push_back(monitorObject);
+	redrawAll = !redrawOnDemand || animating;
+
+	bool redrawing = false;
+
+	for (Size i = 0; i < windowTable.Count(); i++)
+	{
+		windowTable.redrawing[i] = Redraw(i);
+		if (windowTable.redrawing[i]) redrawing = true;
 	}
-	else if (event == GLFW_DISCONNECTED)
+
+	if (lateLatch && redrawing) LatchLateInput();
+
+	// Nothing will be swapped, so there is nothing to wait for
+	if (waitForRenderer && renderSyncMode == RenderSyncMode::Event && redrawing)
 	{
-		Monitor* monitorObject = reinterpret_cast<Monitor*>(glfwGetMonitorUserPointer(monitor));
-		SendEvent(Monitor::DisconnectEvent{monitorObject});
+		SendEvent(RenderWaitEvent {});
+	}
 
-		// Remove monitor from registry
-		monitorRegistry.erase(
-			std::find(monitorRegistry.begin(), monitorRegistry.end(), monitorObject));
+	if (pacer) pacer->MarkWorkDone();
 
-		// Delete monitor object
-		delete monitorObject;
+	// Listeners of the events above may have destroyed windows, so the
+	// windows to swap are only picked now
+	swapList.clear();
+
+	for (Size i = 0; i < windowTable.Count(); i++)
+	{
+		Window* w = windowTable.windows[i];
+		if (w->HasPendingWrites()) w->FlushPendingWrites();
+
+		if (windowTable.redrawing[i] && windowTable.needsSwap[i]) swapList.push_back(windowTable.handles[i]);
 	}
+
+	FinishRedraw();
+
+	SwapWindowBuffers();
+
+	if (pacer) pacer->MarkPresented();
+
+	if (windowTable.closeCount > 0) CloseRequestedWindows();
+
+	SendDiagnostics(frameArena);
+	ResetFrameArena();
 }
 
-VLFWMain::VLFWMain(const VLFWMainArgs& args) :
-	lock(mtx, std::try_to_lock)
+// Hand the frame to the render thread without waiting for it
+void VLFWMain::SubmitRenderFrame()
 {
-	if (!lock.owns_lock())
+	redrawAll = !redrawOnDemand || animating;
+
+	for (Size i = 0; i < windowTable.Count(); i++)
 	{
-		throw std::runtime_error("Multiple concurrent instances of VLFWMain are disallowed.");
-		return;
+		Window* w = windowTable.windows[i];
+		if (w->HasPendingWrites()) w->FlushPendingWrites();
+
+		windowTable.redrawing[i] = Redraw(i);
+		if (windowTable.redrawing[i])
+		{
+			renderJobs.push_back(RenderJob{w, windowTable.handles[i], windowTable.needsSwap[i] != 0});
+		}
 	}
-	
-	glfwSetErrorCallback(ErrorCallback);
 
-	glfwInit();
-	glfwSetMonitorCallback(MonitorConnectedCallback);
+	renderThread->SetWaitForRenderer(waitForRenderer);
+	renderThread->Submit(renderJobs);
 
-	{ // Set Up monitors
-		Int monitorCount;
-		GLFWmonitor** monitors = glfwGetMonitors(&monitorCount);
-		
-		monitorRegistry.clear();
-		monitorRegistry.reserve(monitorCount);
+	FinishRedraw();
 
-		for (Int i = 0; i < monitorCount; i++)
+	if (windowTable.closeCount > 0) CloseRequestedWindows();
+
+	SendDiagnostics(frameArena);
+	ResetFrameArena();
+}
+
+// Groups the characters typed since the last call by window, keeping the
+// order they were typed in, and sends one event per window
+void VLFWMain::SendTextInput()
+{
+	batchingText = batchTextInput;
+	if (typedText.empty()) return;
+
+	// Listeners may destroy windows, which removes their characters
+	for (;;)
+	{
+		Window* window = nullptr;
+		Size count = 0;
+
+		for (auto it = typedText.cbegin(); it != typedText.cend(); it++)
 		{
-			Monitor* monitor = new Monitor(monitors[i]);
-			monitorRegistry.push_back(monitor);
+			if (it->first == nullptr) continue;
+			if (window == nullptr) window = it->first;
+			if (it->first == window) count++;
+		}
+
+		if (window == nullptr) break;
+
+		char32_t* codepoints = frameArena.Allocate<char32_t>(count);
+		Size n = 0;
+
+		for (auto it = typedText.begin(); it != typedText.end(); it++)
+		{
+			if (it->first != window) continue;
+
+			codepoints[n++] = it->second;
+			it->first = nullptr;
 		}
+
+		char* utf8 = frameArena.Allocate<char>(count * 4 + 1);
+		Size length = EncodeUTF8(codepoints, count, utf8);
+		utf8[length] = '\0';
+
+		DispatchEvent(EventPriority::High, Window::TextInputEvent{
+			window,
+			codepoints,
+			count,
+			ArenaString{utf8, length}
+		});
 	}
 
-	waitMode = args.waitMode;
-	waitTimeout = args.waitTimeout;
-	waitForRenderer = args.waitForRenderer;
-	//glfwSwapInterval(args.swapInterval);
+	typedText.clear();
 }
 
-VLFWMain::~VLFWMain()
+void VLFWMain::ResetFrameArena()
 {
-	monitorRegistry.clear();
+	// Events are buffered in order, so the oldest frame still referred to
+	// is at the front of a queue and this frame's events are at the back
+	std::uint64_t oldest = arenaFrame + 1;
+	if (!highEvents.empty()) oldest = std::min(oldest, highEvents.front().frame);
+	if (!lowEvents.empty()) oldest = std::min(oldest, lowEvents.front().frame);
 
-	glfwTerminate();
+	while (!retiredArenas.empty() && retiredArenas.front().frame < oldest)
+	{
+		std::unique_ptr<FrameArena> arena = std::move(retiredArenas.front().arena);
+		retiredArenas.pop_front();
+
+		arena->Reset();
+		if (spareArenas.size() < maxSpareArenas) spareArenas.push_back(std::move(arena));
+	}
+
+	bool referenced =
+		(!highEvents.empty() && highEvents.back().frame == arenaFrame) ||
+		(!lowEvents.empty() && lowEvents.back().frame == arenaFrame);
+
+	if (referenced)
+	{
+		// Hand this frame's payloads to another arena until they are sent
+		std::unique_ptr<FrameArena> arena;
+
+		if (spareArenas.empty())
+		{
+			arena.reset(new FrameArena(frameArena.GetCapacity()));
+		}
+		else
+		{
+			arena = std::move(spareArenas.back());
+			spareArenas.pop_back();
+		}
+
+		arena->Swap(frameArena);
+		retiredArenas.push_back(RetiredArena{arenaFrame, std::move(arena)});
+	}
+	else
+	{
+		frameArena.Reset();
+	}
+
+	arenaFrame++;
 }
 
-// Process Inputs
-void VLFWMain::OnEvent(const vlk::PreUpdateEvent&)
+// Processes events that arrived during the frame and hands the freshest
+// cursor position to listeners, right before buffers are swapped
+void VLFWMain::LatchLateInput()
 {
-	// Process Events
-	// TODO: find a way to expose event processing
-	// TODO: find a way to expose clipboard functionality
-	
-	if (waitMode == WaitMode::Poll)
+	Double start = glfwGetTime();
+	bool activity = activitySeen;
+
+	// Events from the pump are buffered rather than sent, and stay buffered
+	// until SendBufferedEvents() during the next PreUpdateEvent. Sending
+	// them now would let KeyboardMain and MouseMain clear their edges before
+	// any update sees them, and listeners could destroy windows that are
+	// about to be swapped. Events processed before then are buffered behind
+	// them, so order is kept. Cached window state is updated immediately.
+	bufferingEvents = true;
+
+	// Keep pumping while events are still arriving, within the budget
+	do
 	{
+		activitySeen = false;
 		glfwPollEvents();
+		DeliverInjectedInput();
 	}
-	else if (waitTimeout > 0.0)
+	while (activitySeen && glfwGetTime() - start < lateLatchBudget);
+
+	activitySeen = activitySeen || activity;
+
+	for (Size i = 0; i < windowTable.Count(); i++)
 	{
-		glfwWaitEventsTimeout(waitTimeout);
+		if (!windowTable.redrawing[i]) continue;
+
+		double x, y;
+		glfwGetCursorPos(windowTable.handles[i], &x, &y);
+
+		RouteEvent(LateLatchEvent{
+			windowTable.windows[i],
+			Vector2(static_cast<Float>(x), static_cast<Float>(y))
+		});
 	}
-	else
+}
+
+// Works out which windows are throttled this frame, after events have
+// updated their state
+void VLFWMain::UpdateThrottling()
+{
+	Double now = glfwGetTime();
+
+	for (Size i = 0; i < windowTable.Count(); i++)
 	{
-		glfwWaitEvents();
+		ThrottlePolicy policy = windowTable.windows[i]->GetThrottlePolicy();
+
+		if (policy != windowTable.throttle[i])
+		{
+			// Leaving a throttled state should show up to date content
+			// immediately
+			if (policy == ThrottlePolicy::Continue && !windowTable.dirty[i] && !windowTable.minimized[i])
+			{
+				windowTable.dirty[i] = true;
+				windowTable.dirtyCount++;
+			}
+
+			windowTable.throttle[i] = policy;
+			windowTable.nextFrame[i] = now;
+			throttleChanged.push_back(windowTable.windows[i]);
+		}
+
+		switch (policy)
+		{
+			case ThrottlePolicy::Continue:
+				windowTable.skip[i] = false;
+				break;
+
+			case ThrottlePolicy::Pause:
+				windowTable.skip[i] = true;
+				break;
+
+			case ThrottlePolicy::Cap:
+				windowTable.skip[i] = now < windowTable.nextFrame[i];
+				break;
+		}
+	}
+
+	redrawAll = !redrawOnDemand || animating;
+
+	// Sent after the table is updated, listeners may destroy windows
+	while (!throttleChanged.empty())
+	{
+		Window* w = throttleChanged.back();
+		throttleChanged.pop_back();
+		RouteEvent(Window::ThrottleEvent{w, w->GetThrottlePolicy()});
 	}
 }
 
-// Swap buffers, close windows
-void VLFWMain::OnEvent(const vlk::PostUpdateEvent&)
+// Clears the dirty flag of windows redrawn this frame and schedules the next
+// frame of capped windows. Throttled windows are left dirty so they are
+// redrawn once they resume.
+void VLFWMain::FinishRedraw()
 {
-	if (waitForRenderer) SendEvent(RenderWaitEvent {});
+	Double now = glfwGetTime();
 
-	// Check close flags
-	std::vector<Component<Window>*> toClose;
+	for (Size i = 0; i < windowTable.Count(); i++)
+	{
+		if (!windowTable.redrawing[i]) continue;
+		windowTable.redrawing[i] = false;
+
+		if (windowTable.throttle[i] == ThrottlePolicy::Cap)
+		{
+			Double rate = windowTable.windows[i]->GetThrottleRate();
+			windowTable.nextFrame[i] = rate > 0.0 ? now + 1.0 / rate : now;
+		}
+
+		if (windowTable.dirty[i])
+		{
+			windowTable.dirty[i] = false;
+			windowTable.dirtyCount--;
+		}
+	}
+}
+
+void VLFWMain::SwapWindowBuffers()
+{
+	if (swapList.empty()) return;
+
+	if (swapMode == SwapMode::Parallel && swapList.size() > 1)
+	{
+		if (!swapPool) swapPool.reset(new SwapPool());
+
+		// A context may only be current on one thread at a time
+		GLFWwindow* current = glfwGetCurrentContext();
+		glfwMakeContextCurrent(nullptr);
+
+		swapPool->Swap(swapList);
+
+		glfwMakeContextCurrent(current);
+		return;
+	}
+
+	if (swapMode == SwapMode::PrimaryVsync &&
+	    (swapList.front() != vsyncWindow ||
+	     swapList.size() != vsyncSwapCount ||
+	     windowTable.registrations != vsyncRegistrations))
+	{
+		// Only the first window waits for vertical blank, the rest swap
+		// immediately after it
+		GLFWwindow* current = glfwGetCurrentContext();
+
+		for (auto it = swapList.cbegin(); it != swapList.cend(); it++)
+		{
+			glfwMakeContextCurrent(*it);
+			glfwSwapInterval(it == swapList.cbegin() ? 1 : 0);
+		}
+
+		glfwMakeContextCurrent(current);
+		vsyncWindow = swapList.front();
+		vsyncSwapCount = swapList.size();
+		vsyncRegistrations = windowTable.registrations;
+	}
 
-	Component<Window>::ForEach([&toClose](Component<Window>* c)
+	if (renderSyncMode == RenderSyncMode::Fence)
 	{
-		auto client = c->GetContextAPI();
-		// Can only swap buffers of a window with an OpenGL or ES context
-		if (client == ContextAPI::OpenGL || 
-		    client == ContextAPI::OpenGLES)
+		// Fences are created in the window's own context
+		GLFWwindow* current = glfwGetCurrentContext();
+
+		for (auto it = swapList.cbegin(); it != swapList.cend(); it++)
 		{
-			c->SwapBuffers();
+			glfwMakeContextCurrent(*it);
+			SwapWindow(*it);
 		}
 
-		if (c->GetCloseFlag())
+		glfwMakeContextCurrent(current);
+		return;
+	}
+
+	for (auto it = swapList.cbegin(); it != swapList.cend(); it++)
+	{
+		glfwSwapBuffers(*it);
+	}
+}
+
+// Only components can be deleted by VLFWMain, look for any whose close was
+// requested. Other windows are left for the application to destroy.
+void VLFWMain::CloseRequestedWindows()
+{
+	std::vector<Window*> requested;
+
+	for (Size i = 0; i < windowTable.Count(); i++)
+	{
+		if (!windowTable.closeRequested[i]) continue;
+
+		requested.push_back(windowTable.windows[i]);
+		windowTable.closeRequested[i] = false;
+	}
+
+	windowTable.closeCount = 0;
+
+	std::vector<Component<Window>*> toClose;
+
+	Component<Window>::ForEach([&requested, &toClose](Component<Window>* c)
+	{
+		if (std::find(requested.cbegin(), requested.cend(), static_cast<Window*>(c)) != requested.cend())
 		{
 			toClose.push_back(c);
 		}
@@ -142,6 +1881,89 @@ void VLFWMain::SendEmptyEvent()
 	glfwPostEmptyEvent();
 }
 
+void VLFWMain::SendBufferedEvents()
+{
+	bufferingEvents = eventBudget > 0.0;
+
+	eventStats.sent = 0;
+	eventStats.deferred = 0;
+	if (highEvents.empty() && lowEvents.empty()) return;
+
+	// High priority events are never deferred, but the time they take
+	// counts against the budget
+	const Double forever = std::numeric_limits<Double>::infinity();
+	Double deadline = bufferingEvents ? glfwGetTime() + eventBudget : forever;
+
+	eventStats.sent += SendQueuedEvents(highEvents, forever);
+	eventStats.sent += SendQueuedEvents(lowEvents, deadline);
+
+	eventStats.deferred = lowEvents.size();
+	eventStats.totalDeferred += lowEvents.size();
+}
+
+void VLFWMain::NotifyEventPosted()
+{
+	postedEventCount.fetch_add(1);
+	if (waitingForEvents.load()) glfwPostEmptyEvent();
+}
+
+Size VLFWMain::AddTimer(Double delay, Double period)
+{
+	Size id = nextTimerID++;
+
+	timerPeriods[id] = std::max(period, 0.0);
+	PushTimer(glfwGetTime() + std::max(delay, 0.0), id);
+
+	return id;
+}
+
+void VLFWMain::CancelTimer(Size id)
+{
+	timerPeriods.erase(id);
+}
+
+void VLFWMain::FireTimers()
+{
+	Double now = glfwGetTime();
+
+	while (!timerHeap.empty() && timerHeap.front().deadline <= now)
+	{
+		Timer t = PopTimer();
+
+		auto it = timerPeriods.find(t.id);
+		if (it == timerPeriods.end()) continue;
+
+		if (it->second > 0.0)
+		{
+			// Stay on the original schedule, skipping any periods that were
+			// missed entirely rather than firing for each of them
+			Double deadline = t.deadline + it->second;
+			if (deadline <= now)
+			{
+				deadline += std::ceil((now - deadline) / it->second) * it->second;
+				if (deadline <= now) deadline += it->second;
+			}
+
+			PushTimer(deadline, t.id);
+		}
+		else
+		{
+			timerPeriods.erase(it);
+		}
+
+		// Listeners may add or cancel timers
+		SendEvent(TimerEvent{t.id});
+	}
+}
+
+void VLFWMain::SetAnimating(bool a)
+{
+	animating = a;
+
+	// Stay awake for a full idle period after animation stops
+	lastActivity = glfwGetTime();
+}
+
 void VLFWMain::SetSwapInterval(Int interval)
 {
 	glfwSwapInterval(interval);
@@ -152,11 +1974,78 @@ std::string VLFWMain::GetClipboard() const
 	return std::string(glfwGetClipboardString(nullptr));
 }
 
+Size VLFWMain::GetDroppedDiagnosticCount() const
+{
+	return GetDroppedDiagnostics();
+}
+
+ArenaString VLFWMain::GetClipboardText()
+{
+	const char* str = glfwGetClipboardString(nullptr);
+	if (str == nullptr) str = "";
+
+	return frameArena.Copy(str);
+}
+
 void VLFWMain::SetClipboard(const std::string& data)
 {
 	glfwSetClipboardString(nullptr, data.c_str());
 }
 
+void VLFWMain::InjectKeyDown(Window* window, Key key, Int scancode)
+{
+	InjectInput(InjectedInput{InjectedType::Key, reinterpret_cast<GLFWwindow*>(window->GetHandle()),
+		static_cast<Int>(key), scancode, GLFW_PRESS, 0.0, 0.0});
+}
+
+void VLFWMain::InjectKeyUp(Window* window, Key key, Int scancode)
+{
+	InjectInput(InjectedInput{InjectedType::Key, reinterpret_cast<GLFWwindow*>(window->GetHandle()),
+		static_cast<Int>(key), scancode, GLFW_RELEASE, 0.0, 0.0});
+}
+
+void VLFWMain::InjectKeyRepeat(Window* window, Key key, Int scancode)
+{
+	InjectInput(InjectedInput{InjectedType::Key, reinterpret_cast<GLFWwindow*>(window->GetHandle()),
+		static_cast<Int>(key), scancode, GLFW_REPEAT, 0.0, 0.0});
+}
+
+void VLFWMain::InjectChar(Window* window, UInt codepoint)
+{
+	InjectInput(InjectedInput{InjectedType::Char, reinterpret_cast<GLFWwindow*>(window->GetHandle()),
+		static_cast<Int>(codepoint), 0, 0, 0.0, 0.0});
+}
+
+void VLFWMain::InjectMouseButtonDown(Window* window, MouseButton button)
+{
+	InjectInput(InjectedInput{InjectedType::MouseButton, reinterpret_cast<GLFWwindow*>(window->GetHandle()),
+		static_cast<Int>(button), GLFW_PRESS, 0, 0.0, 0.0});
+}
+
+void VLFWMain::InjectMouseButtonUp(Window* window, MouseButton button)
+{
+	InjectInput(InjectedInput{InjectedType::MouseButton, reinterpret_cast<GLFWwindow*>(window->GetHandle()),
+		static_cast<Int>(button), GLFW_RELEASE, 0, 0.0, 0.0});
+}
+
+void VLFWMain::InjectMouseMove(Window* window, Vector2 position)
+{
+	InjectInput(InjectedInput{InjectedType::MouseMove, reinterpret_cast<GLFWwindow*>(window->GetHandle()),
+		0, 0, 0, position.X(), position.Y()});
+}
+
+void VLFWMain::InjectScroll(Window* window, Vector2 delta)
+{
+	InjectInput(InjectedInput{InjectedType::Scroll, reinterpret_cast<GLFWwindow*>(window->GetHandle()),
+		0, 0, 0, delta.X(), delta.Y()});
+}
+
+void VLFWMain::InjectCursorEnter(Window* window, bool entered)
+{
+	InjectInput(InjectedInput{InjectedType::CursorEnter, reinterpret_cast<GLFWwindow*>(window->GetHandle()),
+		entered ? GLFW_TRUE : GLFW_FALSE, 0, 0, 0.0, 0.0});
+}
+
 /////////////////
 //// Monitor ////
 /////////////////
@@ -199,9 +2088,10 @@ Monitor::Monitor(MonitorHandle handle) :
 
 Monitor* Monitor::GetPrimaryMonitor()
 {
-	return reinterpret_cast<Monitor*>(
-		glfwGetMonitorUserPointer(glfwGetPrimaryMonitor()));
+	GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+	if (monitor == nullptr) return nullptr;
 
+	return reinterpret_cast<Monitor*>(glfwGetMonitorUserPointer(monitor));
 }
 
 Int Monitor::GetMonitorCount()
@@ -2,7 +2,10 @@
 
 #include "vulkan/vulkan.h"
 #include "GLFW/glfw3.h"
+#include "Internal.hpp"
 #include "ValkyrieEngine/ValkyrieEngine.hpp"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <atomic>
 #include <map>
@@ -15,81 +18,138 @@ namespace
 	std::map<const Window*, VkInstance> instances;
 	std::map<const Window*, VkSurfaceKHR> surfaces;
 	std::map<VkInstance, std::atomic_int> instanceUsers;
+	std::map<VkInstance, VkDebugUtilsMessengerEXT> messengers;
+
+	// Bits of Window::PendingWrites::dirty and requested
+	enum : UInt
+	{
+		PendingTitle =      0x01,
+		PendingSize =       0x02,
+		PendingPosition =   0x04,
+		PendingOpacity =    0x08,
+		PendingCursorMode = 0x10
+	};
+
+	bool Equal(const Point<Int>& a, const Point<Int>& b)
+	{
+		return a.X() == b.X() && a.Y() == b.Y();
+	}
 }
 
 void CloseCallback(GLFWwindow* window)
 {
 	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	SendEvent(Window::CloseEvent{w});
+
+	// Flag before sending the event so listeners can still cancel it. A
+	// buffered event is only flagged once sent, otherwise VLFWMain could
+	// close the window before listeners have seen the event.
+	auto send = [w]()
+	{
+		SetWindowCloseRequested(w, true);
+		RouteEvent(Window::CloseEvent{w});
+	};
+
+	if (IsBufferingEvents()) BufferEvent(EventPriority::High, w, send);
+	else send();
 }
 
 void ResizeCallback(GLFWwindow* window, Int x, Int y)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
 	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	SendEvent(Window::ResizeEvent{w, Point<Int>(x, y)});
+	WindowAccess::Cache(w).size = Point<Int>(x, y);
+	WindowAccess::Pending(w).requested &= ~PendingSize;
+	DispatchEvent(EventPriority::Low, Window::ResizeEvent{w, Point<Int>(x, y)});
 }
 
 void FramebufferResizeCallback(GLFWwindow* window, Int x, Int y)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
 	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	SendEvent(Window::FramebufferResizeEvent{w, Point<Int>(x, y)});
+	WindowAccess::Cache(w).framebufferSize = Point<Int>(x, y);
+	DispatchEvent(EventPriority::Low, Window::FramebufferResizeEvent{w, Point<Int>(x, y)});
 }
 
 void ContentScaleCallback(GLFWwindow* window, Float x, Float y)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
 	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	SendEvent(Window::ContentScaleChangeEvent{w, Vector2(x, y)});
+	WindowAccess::Cache(w).contentScale = Vector2(x, y);
+	DispatchEvent(EventPriority::Low, Window::ContentScaleChangeEvent{w, Vector2(x, y)});
 }
 
 void MoveCallback(GLFWwindow* window, Int x, Int y)
 {
+	NotifyActivity();
 	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	SendEvent(Window::MoveEvent{w, Point<Int>(x, y)});
+	WindowAccess::Cache(w).position = Point<Int>(x, y);
+	WindowAccess::Pending(w).requested &= ~PendingPosition;
+	DispatchEvent(EventPriority::Low, Window::MoveEvent{w, Point<Int>(x, y)});
 }
 
 void MinimizeCallback(GLFWwindow* window, Int action)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
 	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	SendEvent(Window::MinimizeEvent{w, static_cast<bool>(action)});
+	WindowAccess::Cache(w).minimized = static_cast<bool>(action);
+	SetWindowMinimized(w, static_cast<bool>(action));
+	DispatchEvent(EventPriority::High, Window::MinimizeEvent{w, static_cast<bool>(action)});
 }
 
 void MaximizeCallback(GLFWwindow* window, Int action)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
 	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	SendEvent(Window::MaximizeEvent{w, static_cast<bool>(action)});
+	WindowAccess::Cache(w).maximized = static_cast<bool>(action);
+	DispatchEvent(EventPriority::High, Window::MaximizeEvent{w, static_cast<bool>(action)});
 }
 
 void FocusCallback(GLFWwindow* window, Int action)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
 	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	SendEvent(Window::FocusEvent{w, static_cast<bool>(action)});
+	WindowAccess::Cache(w).focused = static_cast<bool>(action);
+	DispatchEvent(EventPriority::High, Window::FocusEvent{w, static_cast<bool>(action)});
 }
 
 void RefreshCallback(GLFWwindow* window)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
 	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	SendEvent(Window::RefreshEvent{w});
+	DispatchEvent(EventPriority::Low, Window::RefreshEvent{w});
 }
 
 void KeyCallback(GLFWwindow* window, Int key, Int scancode, Int action, Int)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
 	switch (action)
 	{
 		case GLFW_PRESS:
-			SendEvent(Window::KeyDownEvent{
+			DispatchEvent(EventPriority::High, Window::KeyDownEvent{
 				reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)),
 				static_cast<Key>(key),
 				scancode});
+			break;
 		case GLFW_RELEASE:
-			SendEvent(Window::KeyUpEvent{
+			DispatchEvent(EventPriority::High, Window::KeyUpEvent{
 				reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)),
 				static_cast<Key>(key),
 				scancode});
+			break;
 		case GLFW_REPEAT:
-			SendEvent(Window::KeyRepeatEvent{
+			DispatchEvent(EventPriority::High, Window::KeyRepeatEvent{
 				reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)),
 				static_cast<Key>(key),
 				scancode});
+			break;
 		default:
 			break;
 	}
@@ -97,23 +157,27 @@ void KeyCallback(GLFWwindow* window, Int key, Int scancode, Int action, Int)
 
 void CharCallback(GLFWwindow* window, UInt codepoint)
 {
-	SendEvent(Window::CharTypeEvent{
-		reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)),
-		codepoint
-		});
+	NotifyActivity();
+	MarkWindowDirty(window);
+	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+	if (BufferTextInput(w, codepoint)) return;
+
+	DispatchEvent(EventPriority::High, Window::CharTypeEvent{w, codepoint});
 }
 
 void CursorEnterCallback(GLFWwindow* window, Int entered)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
 	if (entered)
 	{
-		SendEvent(Window::CursorEnterEvent{
+		DispatchEvent(EventPriority::High, Window::CursorEnterEvent{
 			reinterpret_cast<Window*>(glfwGetWindowUserPointer(window))
 		});
 	}
 	else
 	{
-		SendEvent(Window::CursorLeaveEvent{
+		DispatchEvent(EventPriority::High, Window::CursorLeaveEvent{
 			reinterpret_cast<Window*>(glfwGetWindowUserPointer(window))
 		});
 	}
@@ -121,24 +185,36 @@ void CursorEnterCallback(GLFWwindow* window, Int entered)
 
 void CursorPosCallback(GLFWwindow* window, double xpos, double ypos)
 {
-	SendEvent(Window::MouseMoveEvent{
-		reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)),
-		Vector2(static_cast<Float>(xpos), static_cast<Float>(ypos))
-	});
+	NotifyActivity();
+	MarkWindowDirty(window);
+	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+	Vector2 position(static_cast<Float>(xpos), static_cast<Float>(ypos));
+
+	if (IsBufferingEvents()) BufferCursorMove(w, position);
+	else RouteEvent(Window::MouseMoveEvent{w, position});
 }
 
 void MouseButtonCallback(GLFWwindow* window, Int button, Int action, Int)
 {
+	NotifyActivity();
+	MarkWindowDirty(window);
+
+	// Clicks land where the cursor was, not where it was last sent
+	if (IsBufferingEvents())
+	{
+		PromoteCursorMove(reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)));
+	}
+
 	if (action == GLFW_PRESS)
 	{
-		SendEvent(Window::MouseButtonDownEvent{
+		DispatchEvent(EventPriority::High, Window::MouseButtonDownEvent{
 			reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)),
 			static_cast<MouseButton>(button)
 		});
 	}
 	else
 	{
-		SendEvent(Window::MouseButtonUpEvent{
+		DispatchEvent(EventPriority::High, Window::MouseButtonUpEvent{
 			reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)),
 			static_cast<MouseButton>(button)
 		});
@@ -147,7 +223,9 @@ void MouseButtonCallback(GLFWwindow* window, Int button, Int action, Int)
 
 void ScrollCallback(GLFWwindow* window, double x, double y)
 {
-	SendEvent(Window::ScrollEvent{
+	NotifyActivity();
+	MarkWindowDirty(window);
+	DispatchEvent(EventPriority::Low, Window::ScrollEvent{
 		reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)),
 		Vector2(static_cast<Float>(x), static_cast<Float>(y))
 	});
@@ -155,17 +233,35 @@ void ScrollCallback(GLFWwindow* window, double x, double y)
 
 void FileDropCallback(GLFWwindow* window, Int count, const char** paths)
 {
-	std::vector<std::string> p(count);
+	NotifyActivity();
+	MarkWindowDirty(window);
+
+	Window* w = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+
+	// GLFW's strings are only valid during the callback
+	FrameArena* arena = GetEventArena();
+
+	if (arena == nullptr)
+	{
+		// Without a VLFWMain nothing is buffered, so the event is sent
+		// before GLFW's strings go away
+		std::vector<ArenaString> p(static_cast<Size>(count));
+		for (Int i = 0; i < count; i++) p[i] = ArenaString{paths[i], std::strlen(paths[i])};
+
+		DispatchEvent(EventPriority::Low, Window::FileDropEvent{w, p.data(), p.size()});
+		return;
+	}
+
+	ArenaString* p = arena->Allocate<ArenaString>(count);
 
 	for (Int i = 0; i < count; i++)
 	{
-		p[i] = paths[i];
+		p[i] = arena->Copy(paths[i]);
 	}
 
-	SendEvent(Window::FileDropEvent{
-		reinterpret_cast<Window*>(glfwGetWindowUserPointer(window)),
-		p
-	});
+	MapDroppedFiles(w, p, static_cast<Size>(count));
+
+	DispatchEvent(EventPriority::Low, Window::FileDropEvent{w, p, static_cast<Size>(count)});
 }
 
 void Window::PollEvents()
@@ -316,6 +412,74 @@ VkInstance CreateVulkanInstance(const WindowHints& hints, const std::vector<cons
 	return instance;
 }
 
+VKAPI_ATTR VkBool32 VKAPI_CALL DebugMessengerCallback(
+	VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+	VkDebugUtilsMessageTypeFlagsEXT type,
+	const VkDebugUtilsMessengerCallbackDataEXT* data,
+	void*)
+{
+	DiagnosticSeverity s = DiagnosticSeverity::Info;
+	if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) s = DiagnosticSeverity::Error;
+	else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) s = DiagnosticSeverity::Warning;
+
+	const char* message = data->pMessage ? data->pMessage : "";
+	ReportDiagnostic(DiagnosticSource::Vulkan, s, data->messageIdNumber, message, std::strlen(message), type);
+
+	// Never abort the call that triggered the message
+	return VK_FALSE;
+}
+
+// Routes validation layer messages into VLFW's diagnostics
+void CreateDebugMessenger(VkInstance instance)
+{
+	auto create = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(
+		glfwGetInstanceProcAddress(instance, "vkCreateDebugUtilsMessengerEXT"));
+	if (create == nullptr) return;
+
+	VkDebugUtilsMessengerCreateInfoEXT createInfo {};
+	createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+	// Only subscribe to messages that will be kept, so the layers do not
+	// call into VLFW for every verbose message
+	createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+
+	switch (GetMinDiagnosticSeverity())
+	{
+		case DiagnosticSeverity::Info:
+			createInfo.messageSeverity |=
+				VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
+				VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+			// Fall through
+		case DiagnosticSeverity::Warning:
+			createInfo.messageSeverity |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+			break;
+		case DiagnosticSeverity::Error:
+			break;
+	}
+	createInfo.messageType =
+		VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+		VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+		VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+	createInfo.pfnUserCallback = DebugMessengerCallback;
+
+	VkDebugUtilsMessengerEXT messenger = VK_NULL_HANDLE;
+	if (create(instance, &createInfo, nullptr, &messenger) == VK_SUCCESS)
+	{
+		messengers[instance] = messenger;
+	}
+}
+
+void DestroyDebugMessenger(VkInstance instance)
+{
+	auto found = messengers.find(instance);
+	if (found == messengers.end()) return;
+
+	auto destroy = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(
+		glfwGetInstanceProcAddress(instance, "vkDestroyDebugUtilsMessengerEXT"));
+	if (destroy != nullptr) destroy(instance, found->second, nullptr);
+
+	messengers.erase(found);
+}
+
 void CreateVulkanSurface()
 {
 
@@ -416,10 +580,26 @@ Window::Window(const WindowHints& hints, Window* share)
 	// Set user pointer and handle association
 	glfwSetWindowUserPointer(window, this);
 	handle = window;
+	tableIndex = static_cast<Size>(-1);
 
 	// Set other members
 	raiseStopOnClose = hints.raiseStopOnClose;
 	contextAPI = hints.contextAPI;
+	deferredWrites = hints.deferredWrites;
+	titleUpdateInterval = hints.titleUpdateInterval;
+	lastTitleUpdate = glfwGetTime();
+	title = hints.title;
+	opacity = 1.0f;
+	cursorMode = CursorMode::Normal;
+	pending = PendingWrites{};
+	minimizedThrottle = hints.minimizedThrottle;
+	hiddenThrottle = hints.hiddenThrottle;
+	unfocusedThrottle = hints.unfocusedThrottle;
+	throttleRate = hints.throttleRate;
+	nextSubscriptionID = 1;
+	deliveryDepth = 0;
+	subscriptionsRemoved = false;
+	Refresh();
 	
 	// Setup callbacks
 	{
@@ -438,6 +618,7 @@ Window::Window(const WindowHints& hints, Window* share)
 		glfwSetMouseButtonCallback(window,        MouseButtonCallback);
 		glfwSetCursorPosCallback(window,          CursorPosCallback);
 		glfwSetScrollCallback(window,             ScrollCallback);
+		glfwSetDropCallback(window,               FileDropCallback);
 	}
 
 	//Create vulkan instance
@@ -456,6 +637,11 @@ Window::Window(const WindowHints& hints, Window* share)
 			CheckValidationLayerSupport(hints);
 			auto extensions(CheckExtensionSupport(hints));
 			instance = CreateVulkanInstance(hints, extensions);
+
+			if (!hints.requiredValidationLayers.empty() && WantsVulkanDebugMessenger())
+			{
+				CreateDebugMessenger(instance);
+			}
 		}
 
 		VkSurfaceKHR surface;
@@ -487,7 +673,11 @@ Window::Window(const WindowHints& hints, Window* share)
 					std::string("Requested OpenGL extensions is not supported: ") + *ext);
 			}
 		}
+
+		if (hints.openglDebugContext && WantsGLDebugOutput()) InstallGLDebugOutput();
 	}
+
+	RegisterWindow(this);
 }
 
 Window::~Window()
@@ -502,6 +692,7 @@ Window::~Window()
 		if (instanceUsers[instance].fetch_sub(1) == 1)
 		{
 			instanceUsers.erase(instance);
+			DestroyDebugMessenger(instance);
 			vkDestroyInstance(instance, nullptr);
 		}
 
@@ -509,6 +700,8 @@ Window::~Window()
 		surfaces.erase(this);
 	}
 
+	UnregisterWindow(this);
+	DiscardInjectedInput(reinterpret_cast<GLFWwindow*>(handle));
 	glfwDestroyWindow(reinterpret_cast<GLFWwindow*>(handle));
 
 	if (raiseStopOnClose) vlk::Application::Stop();
@@ -527,20 +720,17 @@ bool Window::GetCloseFlag() const
 void Window::SetCloseFlag(bool value)
 {
 	glfwSetWindowShouldClose(reinterpret_cast<GLFWwindow*>(handle), value);
+	SetWindowCloseRequested(this, value);
 }
 
 Point<Int> Window::GetSize() const
 {
-	Point<Int> p;
-	glfwGetWindowSize(reinterpret_cast<GLFWwindow*>(handle), &p.X(), &p.Y());
-	return p;
+	return cache.size;
 }
 
 Point<Int> Window::GetFramebufferSize() const
 {
-	Point<Int> p;
-	glfwGetFramebufferSize(reinterpret_cast<GLFWwindow*>(handle), &p.X(), &p.Y());
-	return p;
+	return cache.framebufferSize;
 }
 
 void Window::GetDecoratedSize(Int* left, Int* top, Int* right, Int* bottom) const
@@ -550,14 +740,19 @@ void Window::GetDecoratedSize(Int* left, Int* top, Int* right, Int* bottom) cons
 
 void Window::SetSize(const Point<Int>& size)
 {
+	if (deferredWrites)
+	{
+		pending.size = size;
+		pending.dirty |= PendingSize;
+		return;
+	}
+
 	glfwSetWindowSize(reinterpret_cast<GLFWwindow*>(handle), size.X(), size.Y());
 }
 
 Vector2 Window::GetContentScale() const
 {
-	Vector2 v;
-	glfwGetWindowContentScale(reinterpret_cast<GLFWwindow*>(handle), &v.X(), &v.Y());
-	return v;
+	return cache.contentScale;
 }
 
 void Window::SetSizeLimit(const Point<Int>& min, const Point<Int>& max)
@@ -572,27 +767,167 @@ void Window::SetAspectRatio(const Point<Int>& ratio)
 
 Point<Int> Window::GetPosition() const
 {
-	Point<Int> p;
-	glfwGetWindowPos(reinterpret_cast<GLFWwindow*>(handle), &p.X(), &p.Y());
-	return p;
+	return cache.position;
 }
 
 void Window::SetPosition(const Point<Int>& pos)
 {
+	if (deferredWrites)
+	{
+		pending.position = pos;
+		pending.dirty |= PendingPosition;
+		return;
+	}
+
 	glfwSetWindowPos(reinterpret_cast<GLFWwindow*>(handle), pos.X(), pos.Y());
 }
 
-void Window::SetTitle(const std::string& title)
+void Window::SetTitle(const std::string& t)
 {
-	glfwSetWindowTitle(reinterpret_cast<GLFWwindow*>(handle), title.data());
+	if (deferredWrites)
+	{
+		pending.title = t;
+		pending.dirty |= PendingTitle;
+		return;
+	}
+
+	glfwSetWindowTitle(reinterpret_cast<GLFWwindow*>(handle), t.data());
+	title = t;
+	lastTitleUpdate = glfwGetTime();
+}
+
+void Window::Post(std::function<void(Window&)> command)
+{
+	commands.Push([this, command]() { command(*this); });
+	NotifyWindowCommandPosted();
+}
+
+void Window::ExecutePosted()
+{
+	commands.Execute();
+}
+
+void Window::Unsubscribe(Size id)
+{
+	for (auto it = subscriptions.begin(); it != subscriptions.end(); it++)
+	{
+		for (auto sub = it->second.begin(); sub != it->second.end(); sub++)
+		{
+			if (sub->id != id || !sub->active) continue;
+
+			// The handler may be the one currently running
+			sub->active = false;
+			subscriptionsRemoved = true;
+			if (deliveryDepth == 0) RemoveUnsubscribed();
+			return;
+		}
+	}
+}
+
+void Window::RemoveUnsubscribed()
+{
+	for (auto it = subscriptions.begin(); it != subscriptions.end();)
+	{
+		std::deque<Subscription>& subs = it->second;
+		subs.erase(
+			std::remove_if(subs.begin(), subs.end(),
+				[](const Subscription& sub) { return !sub.active; }),
+			subs.end());
+
+		if (subs.empty()) it = subscriptions.erase(it);
+		else it++;
+	}
+
+	subscriptionsRemoved = false;
+}
+
+ThrottlePolicy Window::GetThrottlePolicy() const
+{
+	if (cache.minimized) return minimizedThrottle;
+	if (!cache.visible) return hiddenThrottle;
+	if (!cache.focused) return unfocusedThrottle;
+
+	return ThrottlePolicy::Continue;
+}
+
+void Window::RequestRedraw()
+{
+	NotifyActivity();
+	MarkWindowDirty(reinterpret_cast<GLFWwindow*>(handle));
+}
+
+bool Window::NeedsRedraw() const
+{
+	return WindowNeedsRedraw(this);
+}
+
+void Window::FlushPendingWrites()
+{
+	if (pending.dirty == 0) return;
+
+	GLFWwindow* window = reinterpret_cast<GLFWwindow*>(handle);
+
+	if (pending.dirty & PendingTitle)
+	{
+		Double now = glfwGetTime();
+
+		if (pending.title == title)
+		{
+			pending.dirty &= ~PendingTitle;
+		}
+		else if (now - lastTitleUpdate >= titleUpdateInterval)
+		{
+			glfwSetWindowTitle(window, pending.title.data());
+			title.swap(pending.title);
+			lastTitleUpdate = now;
+			pending.dirty &= ~PendingTitle;
+		}
+		else
+		{
+			WakeForDeferredWrite(lastTitleUpdate + titleUpdateInterval);
+		}
+	}
+
+	// Size and position are left to the callbacks to cache. A request is
+	// not repeated while it is still in flight, or after it was denied,
+	// until the window reports a size or position of its own.
+	if ((pending.dirty & PendingSize) && !Equal(pending.size, cache.size) &&
+		!((pending.requested & PendingSize) && Equal(pending.size, pending.requestedSize)))
+	{
+		glfwSetWindowSize(window, pending.size.X(), pending.size.Y());
+		pending.requestedSize = pending.size;
+		pending.requested |= PendingSize;
+	}
+
+	if ((pending.dirty & PendingPosition) && !Equal(pending.position, cache.position) &&
+		!((pending.requested & PendingPosition) && Equal(pending.position, pending.requestedPosition)))
+	{
+		glfwSetWindowPos(window, pending.position.X(), pending.position.Y());
+		pending.requestedPosition = pending.position;
+		pending.requested |= PendingPosition;
+	}
+
+	if ((pending.dirty & PendingOpacity) && pending.opacity != opacity)
+	{
+		glfwSetWindowOpacity(window, pending.opacity);
+		opacity = pending.opacity;
+	}
+
+	if ((pending.dirty & PendingCursorMode) && pending.cursorMode != cursorMode)
+	{
+		glfwSetInputMode(window, GLFW_CURSOR, static_cast<Int>(pending.cursorMode));
+		cursorMode = pending.cursorMode;
+	}
+
+	pending.dirty &= PendingTitle;
 }
 
 Monitor* Window::GetMonitor() const
 {
-	return reinterpret_cast<Monitor*>(
-		glfwGetMonitorUserPointer(
-			glfwGetWindowMonitor(
-				reinterpret_cast<GLFWwindow*>(handle))));
+	GLFWmonitor* monitor = glfwGetWindowMonitor(reinterpret_cast<GLFWwindow*>(handle));
+	if (monitor == nullptr) return nullptr;
+
+	return reinterpret_cast<Monitor*>(glfwGetMonitorUserPointer(monitor));
 }
 
 void Window::SetMonitor(Monitor* monitor)
@@ -625,12 +960,12 @@ void Window::SetMonitor(Monitor* monitor, const Area<Int>& area, Int refreshRate
 
 bool Window::IsMaximized() const
 {
-	return glfwGetWindowAttrib(reinterpret_cast<GLFWwindow*>(handle), GLFW_MAXIMIZED);
+	return cache.maximized;
 }
 
 bool Window::IsMinimized() const
 {
-	return glfwGetWindowAttrib(reinterpret_cast<GLFWwindow*>(handle), GLFW_ICONIFIED);
+	return cache.minimized;
 }
 
 void Window::Minimize()
@@ -650,22 +985,25 @@ void Window::Maximize()
 
 bool Window::IsVisible() const
 {
-	return glfwGetWindowAttrib(reinterpret_cast<GLFWwindow*>(handle), GLFW_VISIBLE);
+	return cache.visible;
 }
 
+// GLFW has no callback for visibility, so track it here
 void Window::Show()
 {
 	glfwShowWindow(reinterpret_cast<GLFWwindow*>(handle));
+	cache.visible = true;
 }
 
 void Window::Hide()
 {
 	glfwHideWindow(reinterpret_cast<GLFWwindow*>(handle));
+	cache.visible = false;
 }
 
 bool Window::IsFocused() const
 {
-	return glfwGetWindowAttrib(reinterpret_cast<GLFWwindow*>(handle), GLFW_FOCUSED);
+	return cache.focused;
 }
 
 void Window::Focus()
@@ -678,6 +1016,20 @@ void Window::Notify()
 	glfwRequestWindowAttention(reinterpret_cast<GLFWwindow*>(handle));
 }
 
+void Window::Refresh()
+{
+	GLFWwindow* window = reinterpret_cast<GLFWwindow*>(handle);
+
+	glfwGetWindowSize(window, &cache.size.X(), &cache.size.Y());
+	glfwGetFramebufferSize(window, &cache.framebufferSize.X(), &cache.framebufferSize.Y());
+	glfwGetWindowPos(window, &cache.position.X(), &cache.position.Y());
+	glfwGetWindowContentScale(window, &cache.contentScale.X(), &cache.contentScale.Y());
+	cache.focused = glfwGetWindowAttrib(window, GLFW_FOCUSED);
+	cache.maximized = glfwGetWindowAttrib(window, GLFW_MAXIMIZED);
+	cache.minimized = glfwGetWindowAttrib(window, GLFW_ICONIFIED);
+	cache.visible = glfwGetWindowAttrib(window, GLFW_VISIBLE);
+}
+
 bool Window::IsTransparent() const
 {
 	return glfwGetWindowAttrib(reinterpret_cast<GLFWwindow*>(handle), GLFW_TRANSPARENT_FRAMEBUFFER);
@@ -688,9 +1040,17 @@ Float Window::GetOpacity() const
 	return glfwGetWindowOpacity(reinterpret_cast<GLFWwindow*>(handle));
 }
 
-void Window::SetOpacity(Float opacity)
+void Window::SetOpacity(Float o)
 {
-	glfwSetWindowOpacity(reinterpret_cast<GLFWwindow*>(handle), opacity);
+	if (deferredWrites)
+	{
+		pending.opacity = o;
+		pending.dirty |= PendingOpacity;
+		return;
+	}
+
+	glfwSetWindowOpacity(reinterpret_cast<GLFWwindow*>(handle), o);
+	opacity = o;
 }
 
 bool Window::IsResizable() const
@@ -884,10 +1244,18 @@ CursorMode Window::GetCursorMode() const
 
 void Window::SetCursorMode(CursorMode mode)
 {
+	if (deferredWrites)
+	{
+		pending.cursorMode = mode;
+		pending.dirty |= PendingCursorMode;
+		return;
+	}
+
 	glfwSetInputMode(
 		reinterpret_cast<GLFWwindow*>(handle),
 		GLFW_CURSOR,
 		static_cast<Int>(mode));
+	cursorMode = mode;
 }
 
 void Window::ResetCursor()